@@ -18,6 +18,7 @@ from tf_agents.trajectories.policy_step import PolicyStep
 from beans import ActionBean, RewardBean, StateBean
 
 from agent_factory import AgentEnum, AgentFactory
+from export_weights import export_q_networks, MLP_LAYOUT_FLAT, MLP_LAYOUT_DEEP
 from conf_parser import ConfParser
 import json
 import os
@@ -95,11 +96,21 @@ class AgentFacade():
             name = "choose_power_source"
         )
 
+        self._action_spec_choose_batch = tensor_spec.BoundedTensorSpec(
+            shape=(),
+            dtype=tf.int32,
+            minimum=0,
+            maximum=self._max_batch_size - 1,
+            name="choose_batch"
+        )
+
+        # send actions are repeated for each batch size, see
+        # _decision_path_to_action_bean_flat
         self._action_spec_flat = tensor_spec.BoundedTensorSpec(
             shape=(),
             dtype=tf.int32, 
             minimum=0,
-            maximum=self._n_queues * ActionBean.PowerSourceEnum.NR_POWER_SOURCE, 
+            maximum=self._n_queues * ActionBean.PowerSourceEnum.NR_POWER_SOURCE * self._max_batch_size, 
             name = "choose_action_flat")
 
         self._time_step_spec = ts.time_step_spec(self._observation_spec)
@@ -129,6 +140,7 @@ class AgentFacade():
         # root: {do_nothing, send_message}
         # send_message: {queue_0, queue_1, ...}
         # queue_i: {power_source_0, power_source_1}
+        # power_source_j: {batch_1, batch_2, ...} (only if max_batch_size > 1)
         root = DecisionTreeConsultant(agent_root, "root")
         # since action values can be provided only by leaves of the tree, the root
         # must have a leaf for the do_nothing action. This is implemenfted as a
@@ -136,9 +148,19 @@ class AgentFacade():
         root.add_choice(DecisionTreeConsultant(StubbornAgent(0), "do_nothing"))
         queue_consultant = DecisionTreeConsultant(agent_queue, "choose_queue")
         root.add_choice(queue_consultant)
+        if self._max_batch_size > 1:
+            agent_batch = AgentFactory.create_agent(
+                agent_description = self._agent_description,
+                time_step_spec = self._time_step_spec,
+                action_spec = self._action_spec_choose_batch)
         for i in range(self._n_queues):
-            queue_consultant.add_choice(DecisionTreeConsultant(
-                agent_power_source, f"power_source_for_queue_{i}"))
+            power_source_consultant = DecisionTreeConsultant(
+                agent_power_source, f"power_source_for_queue_{i}")
+            queue_consultant.add_choice(power_source_consultant)
+            if self._max_batch_size > 1:
+                for j in range(ActionBean.PowerSourceEnum.NR_POWER_SOURCE):
+                    power_source_consultant.add_choice(DecisionTreeConsultant(
+                        agent_batch, f"batch_for_power_source_{j}"))
         return root
     
     def _init_decision_tree(self) -> DecisionTreeConsultant:
@@ -172,6 +194,12 @@ class AgentFacade():
 
         self._last_experience = None
         self._n_queues = bean.n_queues
+        # the batch size is part of the action space, so it comes with the agent
+        self._max_batch_size = int(self._agent_description.get("max_batch_size", 1))
+        if self._max_batch_size < 1:
+            raise ValueError("Invalid max batch size: " + str(self._max_batch_size))
+        self._state_buffer = None
+        self._policy_generation = None
         
         self._init_specs()        
         
@@ -180,23 +208,104 @@ class AgentFacade():
         self._file = open(os.environ.get('AGENT_PATH') + "/tests_omnet/log.csv", "w")
         self._file.truncate(0)
         #metto le colonne
-        self._file.write("energy_level;queue_state;charge_rate;send_message;power_source;queue;reward\n")
+        self._file.write("energy_level;queue_state;charge_rate;send_message;power_source;queue;batch_size;reward\n")
     
 
     def get_action(self, state_bean, rewards_bean):
         logging.debug("Getting action for state: " + str(state_bean))
         return self._get_action(state_bean, rewards_bean)
+
+    def attach_state_buffer(self, state_buffer: np.ndarray):
+        """
+        Attaches a buffer holding the state of the node, laid out as in
+        StateBean.observation_spec. The buffer is owned by the caller, which
+        updates it in place before each call to get_action_from_buffer.
+        """
+        if state_buffer.shape != (1 + self._n_queues + 1,):
+            raise ValueError("Invalid state buffer shape: " + str(state_buffer.shape))
+        self._state_buffer = state_buffer
+
+    def attach_policy_generation(self, policy_generation: np.ndarray):
+        """
+        Attaches a one element counter, bumped every time training updates the
+        weights of the agent. The caller uses it to invalidate the decisions
+        it cached.
+        """
+        self._policy_generation = policy_generation
+
+    def get_action_from_buffer(self, reward: float, drop_last_experience: bool = False):
+        """
+        Same as get_action, but the state is read from the buffer attached
+        with attach_state_buffer and the reward is a plain float.
+        If drop_last_experience is true, the reward does not belong to the last
+        action returned (e.g. the caller answered some requests on its own) and
+        the last experience is discarded instead of being trained on.
+        """
+        if drop_last_experience:
+            self._last_experience = None
+        if(self._last_experience is not None):
+            self._train_last_experience(reward)
+
+        # rounds to the same precision used by _get_action
+        observation = np.round(self._state_buffer, -1).astype(np.int32)
+        time_step = tf.constant(observation, dtype=tf.int32, name="state")
+        return self._act(time_step, observation[0], observation[1:-1].tolist(), observation[-1])
+
+    def export_weights(self, path: str):
+        """
+        Exports the Q-networks of the decision tree, so that the policy can be
+        run by AgentClientMlp. Only DQN agents have Q-networks.
+        """
+        if self._agent_description["agent_type"] != AgentEnum.DQN_AGENT:
+            raise ValueError("Only DQN agents can be exported")
+
+        if self._decision_path_to_action_bean_impl == self._decision_path_to_action_bean_flat:
+            layout = MLP_LAYOUT_FLAT
+            consultants = [self._root]
+        else:
+            layout = MLP_LAYOUT_DEEP
+            queue_consultant = self._root._choices[1]
+            # power source consultants of all the queues share the same agent,
+            # and so do batch consultants
+            power_source_consultant = queue_consultant._choices[0]
+            consultants = [self._root, queue_consultant, power_source_consultant]
+            if len(power_source_consultant._choices) > 0:
+                consultants.append(power_source_consultant._choices[0])
+
+        export_q_networks(path, layout, self._agent_description["activation_layer"],
+                          [consultant._agent._q_network for consultant in consultants])
+
+    def _train_last_experience(self, reward: float):
+        # updates agent policy using reward from previous action
+        reward = round(reward, 8)
+        r = tf.constant(value=reward, shape = (), dtype=tf.float32)
+        print("last experience: " + str(self._last_experience))
+        exp = Experience(self._last_experience[0], self._last_experience[1], r)
+        self._file.write(str(reward) + "\n")
+        if self._root.train([exp]) and self._policy_generation is not None:
+            self._policy_generation[0] += 1
+
+    def _act(self, time_step, energy_level, queue_state, charge_rate):
+        action = []
+        self._root.get_decisions(parent_state=time_step, decision_path=action)
+        # Stores the last experience
+        self._last_experience = (time_step, action)
+
+        action_bean = self._decision_path_to_action_bean(action)
+        # only greedy decisions of DQN agents are a function of the state
+        action_bean.cacheable = (self._agent_description["agent_type"] == AgentEnum.DQN_AGENT
+                                 and not any(decision.random for decision in action))
+        self._file.write(str(energy_level) + ";" + str(queue_state) + ";" + str(charge_rate) + ";" + str(action_bean.send_message) + ";" + str(action_bean.power_source) + ";" + str(action_bean.queue) + ";" + str(action_bean.batch_size) + ";")
+
+        logging.debug("Action: " + str(action_bean))
+        return action_bean
     
     def _get_action(self, state, reward):
         # updates agent policy using reward from previous action
         
         if(self._last_experience is not None):
             reward.reward = round(reward.reward, 8)
-            r = tf.constant(value=reward.reward, shape = (), dtype=tf.float32)
-            print("last experience: " + str(self._last_experience))
-            exp = Experience(self._last_experience[0], self._last_experience[1], r)
-            self._file.write(str(reward.reward) + "\n")
-            self._root.train([exp])
+            self._train_last_experience(reward.reward)
 
         
         
@@ -207,26 +316,20 @@ class AgentFacade():
         state.charge_rate = round(state.charge_rate, -1)
         state.queue_state = [round(q, -1) for q in state.queue_state]
         time_step = state.to_tensor(self._n_queues)
-        action = []
-        self._root.get_decisions(parent_state=time_step, decision_path=action)
-        # Stores the last experience
-        self._last_experience = (time_step, action)
-
-        action_bean = self._decision_path_to_action_bean(action)
-        self._file.write(str(state.energy_level) + ";" + str(state.queue_state) + ";" + str(state.charge_rate) + ";" + str(action_bean.send_message) + ";" + str(action_bean.power_source) + ";" + str(action_bean.queue) +";")
-
-        logging.debug("Action: " + str(action_bean))
-        return action_bean
+        return self._act(time_step, state.energy_level, state.queue_state, state.charge_rate)
     
     def _decision_path_to_action_bean_flat(self, decision_path):
         action = action = int(decision_path[0].value.action)
-        if action == self._n_queues * 2:
+        if action == self._n_queues * 2 * self._max_batch_size:
             action_bean = ActionBean(send_message=ActionBean.SendEnum.DO_NOTHING)
             action_bean.power_source = ActionBean.PowerSourceEnum.NO_SOURCE
             action_bean.queue = -1
 
         else:
             action_bean = ActionBean(send_message=ActionBean.SendEnum.SEND_MESSAGE)
+            # batch size b takes actions in [(b - 1) * n_queues * 2, b * n_queues * 2)
+            action_bean.batch_size = action // (self._n_queues * 2) + 1
+            action = action % (self._n_queues * 2)
             action_bean.queue = action // 2  
             if action % 2 == 0:
                 action_bean.power_source = ActionBean.PowerSourceEnum.BATTERY
@@ -247,6 +350,8 @@ class AgentFacade():
             selected_power_source = int(decision_path[2].value.action)
             action_bean.power_source = ActionBean.PowerSourceEnum(selected_power_source)
             action_bean.queue = selected_queue
+            if len(decision_path) > 3:
+                action_bean.batch_size = int(decision_path[3].value.action) + 1
         return action_bean              
     
     def _decision_path_to_action_bean(self, decision_path):
@@ -136,11 +136,25 @@ class ActionBean():
         POWER_CHORD = 1
         NR_POWER_SOURCE = 2
 
-    def __init__(self, send_message : SendEnum, power_source : PowerSourceEnum = PowerSourceEnum.NO_SOURCE, queue : int = -1, random: bool = False):
+    def __init__(self, send_message : SendEnum, power_source : PowerSourceEnum = PowerSourceEnum.NO_SOURCE, queue : int = -1, random: bool = False, batch_size: int = 1):
         self._send_message = send_message
         self._power_source = power_source
         self._queue = queue
         self._random = random
+        self._batch_size = batch_size
+        self._cacheable = False
+
+    @property
+    def cacheable(self):
+        """
+        Whether the same action would be returned for the same state, until
+        the agent is trained again.
+        """
+        return self._cacheable
+
+    @cacheable.setter
+    def cacheable(self, cacheable):
+        self._cacheable = cacheable
 
     @property
     def random(self):
@@ -169,8 +183,19 @@ class ActionBean():
     @queue.setter
     def queue(self, queue):
         self._queue = queue
+
+    @property
+    def batch_size(self):
+        """
+        How many packets are sent from the queue with a single action.
+        """
+        return self._batch_size
+
+    @batch_size.setter
+    def batch_size(self, batch_size):
+        self._batch_size = batch_size
     
     def __str__(self):
-        return "ActionBean(send_message={}, power_source={}, queue={})".format(
-            self.send_message, self.power_source, self.queue)
+        return "ActionBean(send_message={}, power_source={}, queue={}, batch_size={})".format(
+            self.send_message, self.power_source, self.queue, self.batch_size)
     
\ No newline at end of file
@@ -216,8 +216,12 @@ class DecisionTreeConsultant():
             experiences (Iterable[Experience]): The experiences to train the agent on.
             decision_path_level (int, optional): The level of the decision path to consider. Defaults to 0.
             train (bool, optional): Whether to perform training or not. Defaults to True.
+
+        Returns:
+            bool: Whether the weights of any agent in the tree were updated.
         """
         print("training consultant ", self._decision_name)
+        updated = False
         for e in experiences:
         
             e = self._deduce_consultant_experience(e)
@@ -238,9 +242,12 @@ class DecisionTreeConsultant():
             #if hasattr(self._agent, "_q_network"):
             #    print("q values before training: ", self._agent._q_network(trajectory.observation, step_type=trajectory.step_type))
             if not random:
-                self._agent.train(experience=trajectory)
+                loss_info = self._agent.train(experience=trajectory)
             else:
-                self._agent.train(experience=trajectory, random=random)
+                loss_info = self._agent.train(experience=trajectory, random=random)
+            # agents with a replay buffer return no loss when they only store
+            # the experience
+            updated = updated or loss_info is not None
             
             #if hasattr(self._agent, "_q_network"):
             #    print("q values after training: ", self._agent._q_network(trajectory.observation, step_type=trajectory.step_type))
@@ -252,7 +259,8 @@ class DecisionTreeConsultant():
                 next_decision_in_path = e.decision_path[next_decision_path_level]
                 # Finds consultant choice using the Decision name and trains it
                 next_consultant = self._choices[self._choices_name_to_index[next_decision_in_path.name]]
-                next_consultant.train([e], next_decision_path_level)
+                updated = next_consultant.train([e], next_decision_path_level) or updated
+        return updated
 
 # test the DecisionTreeConsultant class
 if __name__ == "__main__":
@@ -0,0 +1,42 @@
+"""
+Exports the Q-networks of the agent to the flat binary file loaded by
+AgentClientMlp (see simulations/src/node/agentc/mlp.h for the layout).
+"""
+
+import struct
+
+import numpy as np
+import tensorflow as tf
+
+from agent_factory import ActivationEnum
+
+MLP_WEIGHTS_MAGIC = 0x4d4c5057
+MLP_WEIGHTS_VERSION = 1
+
+MLP_LAYOUT_FLAT = 0
+MLP_LAYOUT_DEEP = 1
+
+
+def dense_layers(q_network):
+    """
+    Returns the dense layers of a Q-network built by AgentFactory, in order.
+    """
+    # the network is built lazily, at the first call
+    return [layer for layer in q_network._postprocessing_layers
+            if isinstance(layer, tf.keras.layers.Dense)]
+
+
+def export_q_networks(path: str, layout: int, activation: ActivationEnum, q_networks):
+    with open(path, "wb") as file:
+        file.write(struct.pack("<5I", MLP_WEIGHTS_MAGIC, MLP_WEIGHTS_VERSION, layout,
+                               activation.value, len(q_networks)))
+        for q_network in q_networks:
+            layers = dense_layers(q_network)
+            file.write(struct.pack("<I", len(layers)))
+            for layer in layers:
+                kernel, bias = layer.get_weights()
+                num_inputs, num_outputs = kernel.shape
+                file.write(struct.pack("<2I", num_inputs, num_outputs))
+                # keras kernels are [inputs][outputs], rows are written per output
+                file.write(np.ascontiguousarray(kernel.T, dtype="<f4").tobytes())
+                file.write(np.ascontiguousarray(bias, dtype="<f4").tobytes())
@@ -0,0 +1,171 @@
+"""
+Local agent server for AgentClientShm.
+
+Serves the action requests of the simulation runs connected to the shared
+memory segment, with one AgentFacade for each channel. Starting the server
+once pays the interpreter and TensorFlow startup cost for all the runs.
+
+The segment layout mirrors simulations/src/node/agentc/shm_ring.h: keep them
+in sync. Head and tail counters are accessed as aligned 64 bit words, whose
+loads and stores are atomic and ordered on x86.
+
+Usage: python shm_server.py [shm name]
+"""
+
+import mmap
+import os
+import sys
+import time
+
+import numpy as np
+
+from agent import AgentFacade, AgentFacadeBean
+
+SHM_AGENT_MAGIC = 0x434c4147
+SHM_AGENT_VERSION = 1
+SHM_AGENT_DEFAULT_NAME = "/cl_agent"
+SHM_AGENT_MAX_CHANNELS = 32
+SHM_AGENT_MAX_QUEUES = 64
+SHM_AGENT_RING_SIZE = 8
+SHM_AGENT_IMPLEMENTATION_LEN = 240
+
+SHM_CHANNEL_ACTIVE = 2
+
+REQUEST_DTYPE = np.dtype([
+    ("seq", np.uint64),
+    ("reward", np.float32),
+    ("energy", np.float32),
+    ("charge_rate", np.float32),
+    ("num_queues", np.uint32),
+    ("queue_occ", np.float32, (SHM_AGENT_MAX_QUEUES,)),
+])
+
+RESPONSE_DTYPE = np.dtype([
+    ("seq", np.uint64),
+    ("send_message", np.int32),
+    ("power_source", np.int32),
+    ("queue", np.int32),
+    ("msg_to_send", np.int32),
+])
+
+def _ring_dtype(record_dtype):
+    return np.dtype({
+        "names": ["head", "tail", "records"],
+        "formats": [np.uint64, np.uint64, (record_dtype, (SHM_AGENT_RING_SIZE,))],
+        "offsets": [0, 64, 128],
+        "itemsize": 128 + SHM_AGENT_RING_SIZE * record_dtype.itemsize,
+    })
+
+CHANNEL_DTYPE = np.dtype({
+    "names": ["state", "generation", "num_queues", "implementation", "requests", "responses"],
+    "formats": [np.uint32, np.uint32, np.uint32, "S%d" % SHM_AGENT_IMPLEMENTATION_LEN,
+                _ring_dtype(REQUEST_DTYPE), _ring_dtype(RESPONSE_DTYPE)],
+    "offsets": [0, 4, 8, 16, 256, 256 + _ring_dtype(REQUEST_DTYPE).itemsize],
+    "itemsize": 2944,
+})
+
+SEGMENT_DTYPE = np.dtype({
+    "names": ["magic", "version", "num_channels", "channels"],
+    "formats": [np.uint32, np.uint32, np.uint32, (CHANNEL_DTYPE, (SHM_AGENT_MAX_CHANNELS,))],
+    "offsets": [0, 4, 8, 64],
+    "itemsize": 64 + SHM_AGENT_MAX_CHANNELS * CHANNEL_DTYPE.itemsize,
+})
+
+# idle polls before the server starts sleeping between polls
+IDLE_SPIN_POLLS = 1024
+IDLE_SLEEP_S = 50e-6
+
+
+class ShmAgentServer():
+
+    def __init__(self, shm_name: str = SHM_AGENT_DEFAULT_NAME):
+        self._path = "/dev/shm/" + shm_name.lstrip("/")
+        if os.path.exists(self._path):
+            os.unlink(self._path)
+        fd = os.open(self._path, os.O_RDWR | os.O_CREAT | os.O_EXCL, 0o600)
+        os.ftruncate(fd, SEGMENT_DTYPE.itemsize)
+        self._mmap = mmap.mmap(fd, SEGMENT_DTYPE.itemsize)
+        os.close(fd)
+
+        self._segment = np.frombuffer(self._mmap, dtype=SEGMENT_DTYPE, count=1)[0]
+        self._segment["version"] = SHM_AGENT_VERSION
+        self._segment["num_channels"] = SHM_AGENT_MAX_CHANNELS
+        # clients check the magic number before anything else, so it's written last
+        self._segment["magic"] = SHM_AGENT_MAGIC
+
+        self._channels = self._segment["channels"]
+        self._generations = [0] * SHM_AGENT_MAX_CHANNELS
+        self._agents = [None] * SHM_AGENT_MAX_CHANNELS
+        self._state_buffers = [None] * SHM_AGENT_MAX_CHANNELS
+
+    def _build_agent(self, i: int):
+        channel = self._channels[i]
+        n_queues = int(channel["num_queues"])
+        implementation = channel["implementation"].decode()
+        bean = AgentFacadeBean(n_queues=n_queues, agent_description=implementation or None)
+        agent = AgentFacade(bean)
+        state_buffer = np.zeros(1 + n_queues + 1, dtype=np.float32)
+        agent.attach_state_buffer(state_buffer)
+        self._agents[i] = agent
+        self._state_buffers[i] = state_buffer
+        print("Channel {} claimed with {} queues, implementation {}".format(
+            i, n_queues, implementation))
+
+    def _serve_channel(self, i: int) -> bool:
+        channel = self._channels[i]
+        requests = channel["requests"]
+        responses = channel["responses"]
+        served = False
+
+        if channel["state"] != SHM_CHANNEL_ACTIVE:
+            return False
+        if channel["generation"] != self._generations[i]:
+            self._generations[i] = int(channel["generation"])
+            self._build_agent(i)
+
+        while requests["head"] != requests["tail"]:
+            head = int(requests["head"])
+            request = requests["records"][head % SHM_AGENT_RING_SIZE]
+            n_queues = len(self._state_buffers[i]) - 2
+            state_buffer = self._state_buffers[i]
+            state_buffer[0] = request["energy"]
+            state_buffer[1:-1] = request["queue_occ"][:n_queues]
+            state_buffer[-1] = request["charge_rate"]
+            seq = int(request["seq"])
+            reward = float(request["reward"])
+            requests["head"] = head + 1
+
+            action_bean = self._agents[i].get_action_from_buffer(reward)
+
+            # the client waits for each response, so the ring never fills up
+            tail = int(responses["tail"])
+            response = responses["records"][tail % SHM_AGENT_RING_SIZE]
+            response["seq"] = seq
+            response["send_message"] = int(action_bean.send_message)
+            response["power_source"] = int(action_bean.power_source)
+            response["queue"] = int(action_bean.queue)
+            response["msg_to_send"] = int(action_bean.batch_size)
+            responses["tail"] = tail + 1
+            served = True
+
+        return served
+
+    def serve_forever(self):
+        idle_polls = 0
+        try:
+            while True:
+                busy = False
+                for i in range(SHM_AGENT_MAX_CHANNELS):
+                    busy = self._serve_channel(i) or busy
+                if busy:
+                    idle_polls = 0
+                else:
+                    idle_polls += 1
+                    if idle_polls > IDLE_SPIN_POLLS:
+                        time.sleep(IDLE_SLEEP_S)
+        finally:
+            os.unlink(self._path)
+
+
+if __name__ == '__main__':
+    ShmAgentServer(sys.argv[1] if len(sys.argv) > 1 else SHM_AGENT_DEFAULT_NAME).serve_forever()
@@ -0,0 +1,77 @@
+/**
+ * Microbenchmark of the shared memory agent transport.
+ *
+ * Claims a channel of a running agent server (e.g. tools/agent_shm_server)
+ * and measures the mean round trip time of a request, as seen by
+ * AgentClientShm, for an increasing number of queues.
+ *
+ * Usage: agent_shm_bench [iterations] [shm name]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "node/agentc/shm_ring.h"
+
+using namespace std;
+
+#define DEFAULT_ITERATIONS 100000
+// same backoff of AgentClientShm
+#define SPIN_ITERATIONS 1024
+
+static double bench_round_trip(ShmAgentSegment *segment, int num_queues, int iterations)
+{
+    ShmActionRequest request = {};
+    ShmActionResponse response;
+    int channel = shm_agent_claim_channel(segment, num_queues, "bench");
+
+    if (channel < 0){
+        fprintf(stderr, "No free channel\n");
+        exit(1);
+    }
+    ShmAgentChannel &ch = segment->channels[channel];
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i ++){
+        request.seq = i;
+        request.num_queues = num_queues;
+        request.energy = i % 100;
+        for (int q = 0; q < num_queues; q ++){
+            request.queue_occ[q] = (i + q) % 100;
+        }
+        while (!ch.requests.push(request))
+            this_thread::yield();
+        for (int spin = 0; !ch.responses.pop(response) || response.seq != (uint64_t) i; spin ++){
+            if (spin >= SPIN_ITERATIONS)
+                this_thread::yield();
+        }
+    }
+    auto end = chrono::steady_clock::now();
+
+    shm_agent_release_channel(segment, channel);
+    return chrono::duration<double, nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    const char *name = argc > 2 ? argv[2] : SHM_AGENT_DEFAULT_NAME;
+    ShmAgentSegment *segment;
+    string error;
+
+    segment = shm_agent_open(name, error);
+    if (segment == nullptr){
+        fprintf(stderr, "Cannot open agent server segment: %s\n", error.c_str());
+        return 1;
+    }
+
+    printf("%10s %20s\n", "queues", "ns/round trip");
+    for (int num_queues : {1, 4, 16, 64}){
+        printf("%10d %20.1f\n", num_queues, bench_round_trip(segment, num_queues, iterations));
+    }
+
+    shm_agent_close(segment);
+    return 0;
+}
@@ -0,0 +1,127 @@
+/**
+ * Microbenchmark of the reward computation.
+ *
+ * Builds a RewardEngine from the same reward term models used in omnetpp.ini and
+ * measures the mean cost of a RewardEngine::compute() call for an increasing
+ * number of queues, both when every queue changes between two computations
+ * (full mode) and when only one of them does (incremental mode).
+ * The full mode is measured interpreting the signal of each term, running the
+ * compiled signals and with the vectorized queue penalty kernel.
+ *
+ * Usage: reward_engine_bench [iterations]
+*/
+
+#include <omnetpp.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "node/reward/reward_engine.h"
+
+using namespace omnetpp;
+using namespace std;
+
+#define DEFAULT_ITERATIONS 10000
+
+static cValueMap *make_reward_term_model(double weight, const char *signal_text)
+{
+    cValueMap *model = new cValueMap();
+    cOwnedDynamicExpression *signal = new cOwnedDynamicExpression();
+
+    signal->parse(signal_text);
+    model->set("weight", cValue(weight));
+    model->set("signal", cValue(signal));
+    return model;
+}
+
+static cValueMap *make_reward_term_models()
+{
+    cValueMap *models = new cValueMap();
+
+    models->set("pkt_drop_penalty",
+     cValue(make_reward_term_model(1.0/3, "-(priority) * pkt_drop_count")));
+    models->set("queue_occ_penalty",
+     cValue(make_reward_term_model(1.0/3, "-(priority) * queue_occ")));
+    models->set("energy_penalty",
+     cValue(make_reward_term_model(1.0/3, "-energy_consumed * cost_per_mWh")));
+    return models;
+}
+
+static double bench_compute_incremental(cValueMap *models, int num_queues, int iterations)
+{
+    vector<reward_t> power_sources_costs = {0, 1};
+    vector<mWh_t> last_energy_consumed = {0.5, 0.25};
+    vector<mWh_t> max_energy_consumed = {1, 1};
+    QueueStates queue_states;
+    RewardEngine engine(models, num_queues, power_sources_costs);
+    volatile reward_t sink = 0;
+
+    queue_states.resize(num_queues);
+    engine.setIncremental(true);
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i ++){
+        // a single queue update between two computations
+        int q = i % num_queues;
+        queue_states.update(q, i % 100, i % 3, 3);
+        engine.mark_queue_dirty(q);
+        sink = sink + engine.compute(last_energy_consumed, max_energy_consumed, queue_states);
+    }
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, nano>(end - start).count() / iterations;
+}
+
+static double bench_compute(cValueMap *models, int num_queues, int iterations,
+ bool compiled, bool kernel)
+{
+    vector<reward_t> power_sources_costs = {0, 1};
+    vector<mWh_t> last_energy_consumed = {0.5, 0.25};
+    vector<mWh_t> max_energy_consumed = {1, 1};
+    QueueStates queue_states;
+    RewardEngine engine(models, num_queues, power_sources_costs);
+    volatile reward_t sink = 0;
+
+    queue_states.resize(num_queues);
+    engine.setCompiledSignals(compiled);
+    if (kernel && !engine.setKernel(true)){
+        fprintf(stderr, "queue term signals are not linear, kernel not available\n");
+        exit(1);
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i ++){
+        // counts are reset by each computation, so they are refilled every time
+        for (int q = 0; q < num_queues; q ++){
+            queue_states.occupancy[q] = (i + q) % 100;
+            queue_states.pkt_drop_cnt[q] = (i + q) % 3;
+            queue_states.pkt_inbound_cnt[q] = 3;
+        }
+        sink = sink + engine.compute(last_energy_consumed, max_energy_consumed, queue_states);
+    }
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    cStaticFlag dummy;
+    int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+    cValueMap *models = make_reward_term_models();
+
+    printf("queue penalty kernel: %s\n", queue_penalties_kernel_name());
+    printf("%10s %16s %16s %20s %18s %16s %10s\n", "queues", "ns/call", "ns/call/queue",
+     "incremental ns/call", "compiled ns/call", "kernel ns/call", "speedup");
+    for (int num_queues : {1, 4, 16, 64, 256, 1024, 4096}){
+        double ns = bench_compute(models, num_queues, iterations, false, false);
+        double incremental_ns = bench_compute_incremental(models, num_queues, iterations);
+        double compiled_ns = bench_compute(models, num_queues, iterations, true, false);
+        double kernel_ns = bench_compute(models, num_queues, iterations, false, true);
+        printf("%10d %16.1f %16.2f %20.1f %18.1f %16.1f %9.1fx\n", num_queues, ns,
+         ns / num_queues, incremental_ns, compiled_ns, kernel_ns, ns / kernel_ns);
+    }
+
+    delete models;
+    return 0;
+}
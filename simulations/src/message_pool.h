@@ -0,0 +1,236 @@
+#ifndef MESSAGE_POOL_H
+#define MESSAGE_POOL_H
+
+#include <omnetpp.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "DataMsg_m.h"
+#include "QueueStateUpdate_m.h"
+#include "QueueDataRequest_m.h"
+#include "QueueDataResponse_m.h"
+
+using namespace omnetpp;
+using namespace std;
+
+// at most this many released messages of each type are kept for reuse,
+// the others are deleted
+#define MESSAGE_POOL_MAX_FREE 4096
+
+/**
+ * Freelist of messages of type T, shared by all the modules.
+ *
+ * Messages that are created and deleted at packet rate are taken from the pool
+ * with acquire_msg<T>() and given back with release_msg() instead of being
+ * allocated and deleted every time. Released messages are owned by the pool
+ * and are reset by reset(), which is specialized for each pooled type, so
+ * acquired messages look like new ones to their users.
+ *
+ * The pool is created by the first module using it and is owned by that
+ * module, so it is deleted with the network and each run starts with an
+ * empty pool.
+*/
+template <class T>
+class MessagePool : public cSoftOwner {
+
+  protected:
+    static inline MessagePool<T> *instance = nullptr;
+
+    vector<T *> free_msgs;
+    long hits = 0;
+    long misses = 0;
+    long discards = 0;
+    bool stats_recorded = false;
+
+    /**
+     * Brings back a released message to the state of a new one.
+    */
+    void reset(T *msg);
+
+  public:
+    MessagePool(const char *name) : cSoftOwner(name) {
+      free_msgs.reserve(MESSAGE_POOL_MAX_FREE);
+    }
+
+    virtual ~MessagePool() {
+      // messages still in the freelist are deleted by cSoftOwner
+      if (instance == this)
+        instance = nullptr;
+    }
+
+    static MessagePool<T> *getInstance(const char *name) {
+      if (instance == nullptr)
+        instance = new MessagePool<T>(name);
+      return instance;
+    }
+
+    /**
+     * Returns a message from the freelist, or a new one if the freelist is
+     * empty. The message is owned by the calling module.
+    */
+    T *acquire() {
+      T *msg;
+
+      if (free_msgs.empty()){
+        misses ++;
+        return new T();
+      }
+      hits ++;
+      msg = free_msgs.back();
+      free_msgs.pop_back();
+      drop(msg);
+      return msg;
+    }
+
+    /**
+     * Takes back a message owned by the calling module. The message must not
+     * be used by the caller anymore.
+    */
+    void release(T *msg) {
+      if (free_msgs.size() >= MESSAGE_POOL_MAX_FREE){
+        discards ++;
+        delete msg;
+        return;
+      }
+      take(msg);
+      reset(msg);
+      free_msgs.push_back(msg);
+    }
+
+    /**
+     * Records hits, misses and discards of the pool as scalars of the
+     * given component, once per run.
+    */
+    void record_stats(cComponent *component) {
+      string name = getName();
+
+      if (stats_recorded)
+        return;
+      stats_recorded = true;
+      component->recordScalar((name + "_hits").c_str(), hits);
+      component->recordScalar((name + "_misses").c_str(), misses);
+      component->recordScalar((name + "_discards").c_str(), discards);
+    }
+};
+
+template <>
+inline void MessagePool<DataMsg>::reset(DataMsg *msg)
+{
+    msg->setData(0);
+    msg->setQueueing_time(0);
+}
+
+template <>
+inline void MessagePool<QueueStateUpdate>::reset(QueueStateUpdate *msg)
+{
+    msg->setBuffer_pop_percentage(0);
+    msg->setNum_of_dropped(0);
+    msg->setNum_of_inbound(0);
+}
+
+template <>
+inline void MessagePool<QueueDataRequest>::reset(QueueDataRequest *msg)
+{
+    msg->setData_n(0);
+}
+
+/**
+ * Factory helpers of the pooled message types.
+*/
+inline MessagePool<DataMsg> *data_msg_pool()
+{
+    return MessagePool<DataMsg>::getInstance("data_msg_pool");
+}
+
+inline MessagePool<QueueStateUpdate> *queue_state_update_pool()
+{
+    return MessagePool<QueueStateUpdate>::getInstance("queue_state_update_pool");
+}
+
+inline MessagePool<QueueDataRequest> *queue_data_request_pool()
+{
+    return MessagePool<QueueDataRequest>::getInstance("queue_data_request_pool");
+}
+
+inline MessagePool<QueueDataResponse> *queue_data_response_pool()
+{
+    return MessagePool<QueueDataResponse>::getInstance("queue_data_response_pool");
+}
+
+template <class T> T *acquire_msg();
+
+template <>
+inline DataMsg *acquire_msg<DataMsg>()
+{
+    return data_msg_pool()->acquire();
+}
+
+template <>
+inline QueueStateUpdate *acquire_msg<QueueStateUpdate>()
+{
+    return queue_state_update_pool()->acquire();
+}
+
+template <>
+inline QueueDataRequest *acquire_msg<QueueDataRequest>()
+{
+    return queue_data_request_pool()->acquire();
+}
+
+template <>
+inline QueueDataResponse *acquire_msg<QueueDataResponse>()
+{
+    return queue_data_response_pool()->acquire();
+}
+
+inline void release_msg(DataMsg *msg)
+{
+    data_msg_pool()->release(msg);
+}
+
+inline void release_msg(QueueStateUpdate *msg)
+{
+    queue_state_update_pool()->release(msg);
+}
+
+inline void release_msg(QueueDataRequest *msg)
+{
+    queue_data_request_pool()->release(msg);
+}
+
+/**
+ * Data messages and the state update carried by a response go back to
+ * their own pools.
+*/
+template <>
+inline void MessagePool<QueueDataResponse>::reset(QueueDataResponse *msg)
+{
+    QueueStateUpdate *state_update;
+
+    for (size_t i = 0; i < msg->getDataArraySize(); i ++){
+        if (msg->getData(i) != nullptr)
+            release_msg(msg->removeData(i));
+    }
+    msg->setDataArraySize(0);
+    state_update = msg->removeStateUpdate();
+    if (state_update != nullptr)
+        release_msg(state_update);
+}
+
+inline void release_msg(QueueDataResponse *msg)
+{
+    queue_data_response_pool()->release(msg);
+}
+
+/**
+ * Records the stats of all the pools as scalars of the given component.
+*/
+inline void record_message_pool_stats(cComponent *component)
+{
+    data_msg_pool()->record_stats(component);
+    queue_state_update_pool()->record_stats(component);
+    queue_data_request_pool()->record_stats(component);
+    queue_data_response_pool()->record_stats(component);
+}
+
+#endif // MESSAGE_POOL_H
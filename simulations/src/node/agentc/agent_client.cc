@@ -8,6 +8,44 @@ void AgentClient::init_module_params()
     
 }
 
+cValueMap *AgentClient::parse_implementation()
+{
+    cDynamicExpression expression;
+    cValue value;
+
+    // JSON objects are valid NED object literals
+    try {
+        expression.parse(implementation);
+        value = expression.evaluate();
+    } catch (exception &e) {
+        throw cRuntimeError("Cannot parse implementation %s: %s", implementation, e.what());
+    }
+    if (value.getType() != cValue::OBJECT || dynamic_cast<cValueMap *>(value.objectValue()) == nullptr)
+        throw cRuntimeError("Implementation %s is not a JSON object", implementation);
+
+    return (cValueMap *) value.objectValue();
+}
+
+void AgentClient::flat_action_to_msg(int action, size_t num_of_queues, int max_batch_size,
+ ActionResponse *msg)
+{
+    int num_send_actions = (int) num_of_queues * 2;
+
+    if (action == num_send_actions * max_batch_size){
+        msg->setSend_message(false);
+        msg->setSelect_power_source((SelectPowerSource) -1);
+        msg->setQueue(-1);
+        msg->setMsg_to_send(1);
+    } else {
+        msg->setSend_message(true);
+        msg->setMsg_to_send(action / num_send_actions + 1);
+        action %= num_send_actions;
+        msg->setQueue(action / 2);
+        msg->setSelect_power_source(action % 2 == 0 ? SelectPowerSource::BATTERY
+         : SelectPowerSource::POWER_CHORD);
+    }
+}
+
 void AgentClient::initialize()
 {
     init_module_params();
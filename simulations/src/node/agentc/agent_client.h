@@ -3,10 +3,16 @@
 
 #include <omnetpp.h>
 #include "ActionRequest_m.h"
+#include "ActionResponse_m.h"
+#include <cmath>
+#include <cstdint>
 
 using namespace omnetpp;
 using namespace std;
 
+// states are quantized to multiples of 10 percent, as the Python agent does
+#define STATE_NUM_LEVELS 11
+
 /**
  * Interface of clients to the agent.
  * An agent client is a node component able to interact with the 
@@ -21,6 +27,34 @@ class AgentClient : public cSimpleModule {
         char *implementation;
 
         void init_module_params();
+
+        /**
+         * Parses the implementation parameter, a JSON object, into a map.
+         * The map is owned by the caller.
+        */
+        cValueMap *parse_implementation();
+
+        /**
+         * Quantizes a percentage to its level in [0, STATE_NUM_LEVELS), rounding
+         * half to even like round(value, -1) in AgentFacade._get_action.
+        */
+        static uint32_t quantize_percentage(percentage_t value) {
+            double level = nearbyint(value / 10);
+
+            if (level < 0) return 0;
+            if (level > STATE_NUM_LEVELS - 1) return STATE_NUM_LEVELS - 1;
+            return (uint32_t) level;
+        }
+
+        /**
+         * Converts an action of the flat action space of the agent to a response:
+         * action num_of_queues * 2 * max_batch_size means do nothing, otherwise
+         * action / (num_of_queues * 2) + 1 is the batch size and, with a the
+         * remainder, a / 2 is the queue and a % 2 the power source.
+         * See AgentFacade._decision_path_to_action_bean_flat.
+        */
+        static void flat_action_to_msg(int action, size_t num_of_queues, int max_batch_size,
+         ActionResponse *msg);
     
         virtual void handleActionRequest(ActionRequest *msg) = 0;
         void initialize() override;
@@ -0,0 +1,145 @@
+#include "agent_client_heuristic.h"
+#include <algorithm>
+#include <regex>
+
+Define_Module(AgentClientHeuristic);
+
+static void do_nothing_msg(ActionResponse *msg)
+{
+    msg->setSend_message(false);
+    msg->setSelect_power_source((SelectPowerSource) -1);
+    msg->setQueue(-1);
+    msg->setMsg_to_send(1);
+}
+
+int AgentClientHeuristic::longest_queue(const NodeStateMsg &state)
+{
+    size_t num_queue_states = min(num_of_queues, state.getQueue_pop_percentageArraySize());
+    int queue = -1;
+    percentage_t max_occupancy = 0;
+
+    for (size_t i = 0; i < num_queue_states; i ++){
+        if (state.getQueue_pop_percentage(i) > max_occupancy){
+            max_occupancy = state.getQueue_pop_percentage(i);
+            queue = i;
+        }
+    }
+    return queue;
+}
+
+int AgentClientHeuristic::next_round_robin_queue(const NodeStateMsg &state)
+{
+    size_t num_queue_states = min(num_of_queues, state.getQueue_pop_percentageArraySize());
+    size_t queue;
+
+    for (size_t i = 0; i < num_queue_states; i ++){
+        queue = (next_queue + i) % num_queue_states;
+        if (state.getQueue_pop_percentage(queue) > 0){
+            next_queue = queue + 1;
+            return queue;
+        }
+    }
+    return -1;
+}
+
+SelectPowerSource AgentClientHeuristic::threshold_power_source(const NodeStateMsg &state)
+{
+    return state.getEnergy_percentage() >= battery_threshold ? SelectPowerSource::BATTERY
+     : SelectPowerSource::POWER_CHORD;
+}
+
+void AgentClientHeuristic::decide(const NodeStateMsg &state, ActionResponse *msg)
+{
+    int queue;
+
+    switch (policy)
+    {
+    case HeuristicPolicy::RANDOM:
+        flat_action_to_msg(intuniform(0, num_of_queues * 2 * max_batch_size), num_of_queues,
+         max_batch_size, msg);
+        return;
+    case HeuristicPolicy::BATTERY_THRESHOLD:
+        if (threshold_power_source(state) != SelectPowerSource::BATTERY){
+            do_nothing_msg(msg);
+            return;
+        }
+        queue = longest_queue(state);
+        break;
+    case HeuristicPolicy::ROUND_ROBIN:
+        queue = next_round_robin_queue(state);
+        break;
+    case HeuristicPolicy::LONGEST_QUEUE_FIRST:
+    default:
+        queue = longest_queue(state);
+        break;
+    }
+
+    if (queue < 0){
+        do_nothing_msg(msg);
+        return;
+    }
+    msg->setSend_message(true);
+    msg->setQueue(queue);
+    msg->setSelect_power_source(threshold_power_source(state));
+    msg->setMsg_to_send(batch_size);
+}
+
+void AgentClientHeuristic::handleActionRequest(ActionRequest *msg)
+{
+    ActionResponse *response;
+
+    EV_DEBUG << "Agent client received action request" << endl;
+
+    response = new ActionResponse();
+    decide(msg->getState(), response);
+
+    EV_DEBUG << "Heuristic agent selected send " << response->getSend_message() << " queue "
+     << response->getQueue() << " power source " << response->getSelect_power_source()
+     << " batch " << response->getMsg_to_send() << endl;
+
+    this->send(response, "port$o");
+}
+
+void AgentClientHeuristic::initialize()
+{
+    AgentClient::initialize();
+
+    init_module_params();
+}
+
+void AgentClientHeuristic::init_module_params()
+{
+    cValueMap *conf;
+    string agent_type;
+    regex random_pattern("random_agent|randomagent|random|random-agent");
+    regex longest_queue_pattern("longest_queue|longest-queue|longest_queue_first|lqf");
+    regex battery_threshold_pattern("battery_threshold|battery-threshold|threshold");
+    regex round_robin_pattern("round_robin|round-robin|roundrobin|rr");
+
+    num_of_queues = par("num_of_queues").intValue();
+
+    conf = parse_implementation();
+    agent_type = conf->containsKey("agent_type") ? conf->get("agent_type").stdstringValue() : "";
+    battery_threshold = conf->containsKey("battery_threshold")
+     ? conf->get("battery_threshold").doubleValue() : HEURISTIC_BATTERY_THRESHOLD;
+    batch_size = conf->containsKey("batch_size") ? conf->get("batch_size").intValue() : 1;
+    max_batch_size = conf->containsKey("max_batch_size") ? conf->get("max_batch_size").intValue() : 1;
+    delete conf;
+
+    if (regex_match(agent_type, random_pattern))
+        policy = HeuristicPolicy::RANDOM;
+    else if (regex_match(agent_type, longest_queue_pattern))
+        policy = HeuristicPolicy::LONGEST_QUEUE_FIRST;
+    else if (regex_match(agent_type, battery_threshold_pattern))
+        policy = HeuristicPolicy::BATTERY_THRESHOLD;
+    else if (regex_match(agent_type, round_robin_pattern))
+        policy = HeuristicPolicy::ROUND_ROBIN;
+    else
+        throw cRuntimeError("AgentClientHeuristic does not support agent type '%s', "
+         "check the implementation parameter", agent_type.c_str());
+    if (batch_size < 1 || max_batch_size < 1)
+        throw cRuntimeError("Invalid batch size, it must be at least 1");
+
+    EV_DEBUG << "Heuristic agent " << agent_type << " with battery threshold "
+     << battery_threshold << "% and batch size " << batch_size << endl;
+}
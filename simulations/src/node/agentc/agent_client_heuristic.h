@@ -0,0 +1,65 @@
+#ifndef AGENT_CLIENT_HEURISTIC_H
+#define AGENT_CLIENT_HEURISTIC_H
+
+#include "agent_client.h"
+#include <cstddef>
+
+// default battery level (percentage) over which the battery is used
+#define HEURISTIC_BATTERY_THRESHOLD 50
+
+enum class HeuristicPolicy {
+  // uniform over the flat action space of the agent
+  RANDOM,
+  // sends from the fullest queue, with the battery if charged enough
+  LONGEST_QUEUE_FIRST,
+  // sends from the fullest queue only while the battery is charged enough
+  BATTERY_THRESHOLD,
+  // sends from the non empty queues in turn, with the battery if charged enough
+  ROUND_ROBIN
+};
+
+/**
+ * Agent client running a fixed baseline policy in C++, with no learning
+ * and no Python involved.
+ *
+ * The policy is selected by the agent_type of the implementation parameter,
+ * so baseline runs only change the typename of the agent, e.g.
+ * {"agent_type": "longest_queue", "battery_threshold": 30, "batch_size": 2}
+ * Supported agent types: random, longest_queue, battery_threshold and
+ * round_robin. max_batch_size works as for the Python agent for the random
+ * policy, batch_size is the number of packets sent by the other ones.
+*/
+class AgentClientHeuristic : public AgentClient {
+    protected:
+        // next queue to be served by ROUND_ROBIN
+        size_t next_queue = 0;
+
+        /**
+         * Module parameters:
+        */
+        size_t num_of_queues;
+        HeuristicPolicy policy;
+        percentage_t battery_threshold;
+        int batch_size;
+        int max_batch_size;
+        /* Module parameters (END)*/
+
+        /**
+         * Returns the fullest non empty queue, or -1 if all the queues are empty.
+        */
+        int longest_queue(const NodeStateMsg &state);
+        /**
+         * Returns the next non empty queue in turn, or -1 if all the queues
+         * are empty.
+        */
+        int next_round_robin_queue(const NodeStateMsg &state);
+        SelectPowerSource threshold_power_source(const NodeStateMsg &state);
+        void decide(const NodeStateMsg &state, ActionResponse *msg);
+
+        void handleActionRequest(ActionRequest *msg) override;
+        void initialize() override;
+
+        void init_module_params();
+};
+
+#endif // AGENT_CLIENT_HEURISTIC_H
@@ -0,0 +1,115 @@
+#include "agent_client_mlp.h"
+#include <algorithm>
+
+Define_Module(AgentClientMlp);
+
+void AgentClientMlp::state_msg_to_observation(const NodeStateMsg &state)
+{
+    size_t num_queue_states = state.getQueue_pop_percentageArraySize();
+
+    // same rounding of AgentFacade._get_action
+    observation[0] = quantize_percentage(state.getEnergy_percentage()) * 10;
+    for (size_t i = 0; i < num_of_queues; i ++){
+        observation[1 + i] = i < num_queue_states
+         ? quantize_percentage(state.getQueue_pop_percentage(i)) * 10 : 0;
+    }
+    observation[1 + num_of_queues] = quantize_percentage(state.getCharge_rate_percentage()) * 10;
+}
+
+void AgentClientMlp::decide(ActionResponse *msg)
+{
+    vector<Mlp> &networks = weights.networks;
+    int queue;
+    int power_source;
+
+    if (weights.layout == MLP_LAYOUT_FLAT){
+        flat_action_to_msg(networks[0].argmax(observation.data()), num_of_queues,
+         max_batch_size, msg);
+        return;
+    }
+
+    // root: {do_nothing, send_message}
+    msg->setMsg_to_send(1);
+    if (networks[0].argmax(observation.data()) == 0){
+        msg->setSend_message(false);
+        msg->setSelect_power_source((SelectPowerSource) -1);
+        msg->setQueue(-1);
+        return;
+    }
+    queue = networks[1].argmax(observation.data());
+    power_source = networks[2].argmax(observation.data());
+    msg->setSend_message(true);
+    msg->setQueue(queue);
+    msg->setSelect_power_source((SelectPowerSource) power_source);
+    if (networks.size() > 3)
+        msg->setMsg_to_send(networks[3].argmax(observation.data()) + 1);
+}
+
+void AgentClientMlp::handleActionRequest(ActionRequest *msg)
+{
+    ActionResponse *response;
+
+    EV_DEBUG << "Agent client received action request" << endl;
+
+    state_msg_to_observation(msg->getState());
+    response = new ActionResponse();
+    decide(response);
+
+    EV_DEBUG << "MLP agent selected send " << response->getSend_message() << " queue "
+     << response->getQueue() << " power source " << response->getSelect_power_source()
+     << " batch " << response->getMsg_to_send() << endl;
+
+    this->send(response, "port$o");
+}
+
+void AgentClientMlp::initialize()
+{
+    AgentClient::initialize();
+
+    init_module_params();
+    init_networks();
+}
+
+void AgentClientMlp::init_module_params()
+{
+    num_of_queues = par("num_of_queues").intValue();
+    weights_file = par("weights_file").stringValue();
+}
+
+void AgentClientMlp::init_networks()
+{
+    size_t num_inputs = 1 + num_of_queues + 1;
+    vector<uint32_t> num_outputs;
+    string error;
+
+    if (!load_mlp_weights(weights_file, weights, error))
+        throw cRuntimeError("Cannot load agent weights: %s", error.c_str());
+
+    // checks the networks match the action specs of AgentFacade._init_specs,
+    // the batch size range is the one the agent was trained with
+    if (weights.layout == MLP_LAYOUT_FLAT){
+        if (!weights.networks.empty())
+            max_batch_size = max<int>(1, (weights.networks[0].getNumOutputs() - 1) / (num_of_queues * 2));
+        num_outputs = {(uint32_t) (num_of_queues * 2 * max_batch_size + 1)};
+    }
+    else {
+        num_outputs = {2, (uint32_t) num_of_queues, 2};
+        if (weights.networks.size() > 3){
+            max_batch_size = weights.networks[3].getNumOutputs();
+            num_outputs.push_back(max_batch_size);
+        }
+    }
+    if (weights.networks.size() != num_outputs.size())
+        throw cRuntimeError("%s has %d networks instead of %d", weights_file,
+         (int) weights.networks.size(), (int) num_outputs.size());
+    for (size_t i = 0; i < num_outputs.size(); i ++){
+        if (weights.networks[i].getNumInputs() != num_inputs
+         || weights.networks[i].getNumOutputs() != num_outputs[i])
+            throw cRuntimeError("Network %d of %s does not match %d queues", (int) i,
+             weights_file, (int) num_of_queues);
+    }
+    observation.resize(num_inputs);
+
+    EV_DEBUG << "Loaded " << weights.networks.size() << " networks from "
+     << weights_file << ", max batch size " << max_batch_size << endl;
+}
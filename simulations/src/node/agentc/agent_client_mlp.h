@@ -0,0 +1,44 @@
+#ifndef AGENT_CLIENT_MLP_H
+#define AGENT_CLIENT_MLP_H
+
+#include "agent_client.h"
+#include "mlp.h"
+#include <vector>
+
+/**
+ * Agent client running greedy inference of a frozen DQN policy in C++.
+ *
+ * Q-networks are exported from a trained agent by agent/export_weights.py
+ * (see AgentClient export_weights parameter). Both the flat and the deep
+ * decision tree layouts are supported: the deep one goes through the root,
+ * choose queue and choose power source networks like
+ * DecisionTreeConsultant.get_decisions does, followed by the choose batch
+ * network if the agent picks batch sizes.
+ * The maximum batch size is deduced from the shape of the networks.
+*/
+class AgentClientMlp : public AgentClient {
+    protected:
+        MlpWeights weights;
+        // quantized state, as fed to the Q-networks
+        vector<float> observation;
+
+        /**
+         * Module parameters:
+        */
+        size_t num_of_queues;
+        const char *weights_file;
+        /* Module parameters (END)*/
+
+        int max_batch_size = 1;
+
+        void state_msg_to_observation(const NodeStateMsg &state);
+        void decide(ActionResponse *msg);
+
+        void handleActionRequest(ActionRequest *msg) override;
+        void initialize() override;
+
+        void init_module_params();
+        void init_networks();
+};
+
+#endif // AGENT_CLIENT_MLP_H
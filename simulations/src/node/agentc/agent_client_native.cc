@@ -0,0 +1,118 @@
+#include "agent_client_native.h"
+#include <algorithm>
+#include <regex>
+
+Define_Module(AgentClientNative);
+
+// default size limit of the Q-table
+#define Q_LEARNING_MAX_STATES (1 << 22)
+
+uint64_t AgentClientNative::quantize_state(const NodeStateMsg &state)
+{
+    size_t num_queue_states = state.getQueue_pop_percentageArraySize();
+
+    levels[0] = quantize_percentage(state.getEnergy_percentage());
+    for (size_t i = 0; i < num_of_queues; i ++){
+        levels[1 + i] = i < num_queue_states ? quantize_percentage(state.getQueue_pop_percentage(i)) : 0;
+    }
+    levels[1 + num_of_queues] = quantize_percentage(state.getCharge_rate_percentage());
+
+    return q_table->state_index(levels.data());
+}
+
+int AgentClientNative::select_action(uint64_t state)
+{
+    int action;
+
+    if (uniform(0, 1) < epsilon)
+        action = intuniform(0, q_table->getNumActions() - 1);
+    else
+        action = q_table->best_action(state);
+
+    epsilon = std::max(min_epsilon, epsilon * epsilon_decay);
+    return action;
+}
+
+void AgentClientNative::handleActionRequest(ActionRequest *msg)
+{
+    uint64_t state;
+    int action;
+    ActionResponse *response;
+
+    EV_DEBUG << "Agent client received action request" << endl;
+
+    state = quantize_state(msg->getState());
+    // updates the value of the last action with the reward it got
+    if (has_last_experience)
+        q_table->update(last_state, last_action, msg->getReward().getValue(), state,
+         learning_rate, discount);
+
+    action = select_action(state);
+    last_state = state;
+    last_action = action;
+    has_last_experience = true;
+
+    EV_DEBUG << "Q-learning agent selected action " << action << " in state "
+     << state << endl;
+
+    response = new ActionResponse();
+    flat_action_to_msg(action, num_of_queues, max_batch_size, response);
+    this->send(response, "port$o");
+}
+
+void AgentClientNative::initialize()
+{
+    AgentClient::initialize();
+
+    init_module_params();
+}
+
+void AgentClientNative::init_module_params()
+{
+    cValueMap *conf;
+    string q_table_path;
+    regex q_learning_pattern("q_learning|qlearning|q-learning|tabular");
+    auto get_double = [&conf](const char *key, double default_value){
+        return conf->containsKey(key) ? conf->get(key).doubleValue() : default_value;
+    };
+
+    num_of_queues = par("num_of_queues").intValue();
+
+    conf = parse_implementation();
+    if (!conf->containsKey("agent_type")
+     || !regex_match(conf->get("agent_type").stdstringValue(), q_learning_pattern)){
+        delete conf;
+        throw cRuntimeError("AgentClientNative supports only q_learning agents, "
+         "check the implementation parameter");
+    }
+    learning_rate = get_double("learning_rate", 0.1);
+    discount = get_double("gamma", 0.9);
+    epsilon = get_double("epsilon_greedy", 0.1);
+    epsilon_decay = get_double("epsilon_decay", 1);
+    min_epsilon = get_double("min_epsilon", 0);
+    max_batch_size = conf->containsKey("max_batch_size") ? conf->get("max_batch_size").intValue() : 1;
+    if (conf->containsKey("q_table"))
+        q_table_path = conf->get("q_table").stdstringValue();
+    delete conf;
+    if (max_batch_size < 1)
+        throw cRuntimeError("Invalid max_batch_size %d", max_batch_size);
+
+    levels.resize(1 + num_of_queues + 1);
+    q_table = new QTable(q_table_path, STATE_NUM_LEVELS, levels.size(),
+     num_of_queues * 2 * max_batch_size + 1, Q_LEARNING_MAX_STATES);
+
+    EV_DEBUG << "Q-learning agent with " << q_table->getNumStates() << " states and "
+     << q_table->getNumActions() << " actions, " << q_table->getNumUpdates()
+     << " updates from previous runs" << endl;
+}
+
+void AgentClientNative::finish()
+{
+    recordScalar("q_table_updates", q_table->getNumUpdates());
+    recordScalar("final_epsilon", epsilon);
+}
+
+AgentClientNative::~AgentClientNative()
+{
+    delete q_table;
+}
@@ -0,0 +1,55 @@
+#ifndef AGENT_CLIENT_NATIVE_H
+#define AGENT_CLIENT_NATIVE_H
+
+#include "agent_client.h"
+#include "q_table.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Agent client running an epsilon-greedy tabular Q-learning agent in C++,
+ * with no Python involved.
+ *
+ * The state [energy, q_1, ..., q_n, charge_rate] is quantized like in
+ * AgentFacade._get_action, and actions use the flat action space of the
+ * Python agent (see AgentFacade._decision_path_to_action_bean_flat).
+ *
+ * Hyperparameters are read from the implementation parameter, e.g.
+ * {"agent_type": "q_learning", "learning_rate": 0.1, "gamma": 0.9,
+ *  "epsilon_greedy": 0.1, "q_table": "q_table_node0.bin"}
+ * A max_batch_size greater than 1 adds the batch size to the actions.
+*/
+class AgentClientNative : public AgentClient {
+    protected:
+        QTable *q_table = nullptr;
+        vector<uint32_t> levels;
+
+        bool has_last_experience = false;
+        uint64_t last_state;
+        int last_action;
+
+        /**
+         * Module parameters:
+        */
+        size_t num_of_queues;
+        double learning_rate;
+        double discount;
+        double epsilon;
+        double epsilon_decay;
+        double min_epsilon;
+        int max_batch_size;
+        /* Module parameters (END)*/
+
+        uint64_t quantize_state(const NodeStateMsg &state);
+        int select_action(uint64_t state);
+
+        void handleActionRequest(ActionRequest *msg) override;
+        void initialize() override;
+        void finish() override;
+
+        void init_module_params();
+    public:
+        ~AgentClientNative();
+};
+
+#endif // AGENT_CLIENT_NATIVE_H
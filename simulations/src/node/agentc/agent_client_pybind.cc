@@ -2,27 +2,32 @@
 #include "agent_client.h"
 #include "python_interpreter.h"
 #include <omnetpp.h>
+#include "statistics.h"
+#include <chrono>
+#include <fstream>
 #include <cstddef>
 
 Define_Module(AgentClientPybind);
 
+AgentClientPybind *AgentClientPybind::agent_output_owner = nullptr;
+
 AgentClientPybind::AgentClientPybind()
 {
 }
 
-void AgentClientPybind::state_msg_to_bean(const NodeStateMsg &state, py::object bean){
+void AgentClientPybind::state_msg_to_buffer(const NodeStateMsg &state){
 
-    bean.attr("energy_level") = state.getEnergy_percentage();
-    bean.attr("charge_rate") = state.getCharge_rate_percentage();
-    for (int i = 0; i < state.getQueue_pop_percentageArraySize(); i ++){
-        bean.attr("add_queue_state")(state.getQueue_pop_percentage(i));
-    }
+    size_t num_queue_states = state.getQueue_pop_percentageArraySize();
 
-}
+    if (num_queue_states != num_of_queues)
+        EV_WARN << "State has " << num_queue_states << " queues instead of "
+         << num_of_queues << ", it will be padded with zeros or truncated" << endl;
 
-void AgentClientPybind::reward_msg_to_bean(const RewardMsg &msg, py::object reward_bean)
-{
-    reward_bean.attr("reward") = msg.getValue();
+    state_buffer[0] = state.getEnergy_percentage();
+    for (size_t i = 0; i < num_of_queues; i ++){
+        state_buffer[1 + i] = i < num_queue_states ? state.getQueue_pop_percentage(i) : 0;
+    }
+    state_buffer[1 + num_of_queues] = state.getCharge_rate_percentage();
 }
 
 void AgentClientPybind::action_bean_to_msg(py::object bean, ActionResponse *msg){
@@ -30,40 +35,130 @@ void AgentClientPybind::action_bean_to_msg(py::object bean, ActionResponse *msg)
     msg->setSend_message(bean.attr("send_message").cast<bool>());
     msg->setSelect_power_source((SelectPowerSource)(bean.attr("power_source").cast<int>()));
     msg->setQueue(bean.attr("queue").cast<int>());
-    msg->setMsg_to_send(1);
+    msg->setMsg_to_send(bean.attr("batch_size").cast<int>());
+}
+
+uint64_t AgentClientPybind::state_key()
+{
+    for (size_t i = 0; i < state_buffer.size(); i ++){
+        state_levels[i] = quantize_percentage(state_buffer[i]);
+    }
+    return DecisionCache::key(state_levels.data(), state_levels.size());
+}
+
+bool AgentClientPybind::answer_from_cache(uint64_t key, ActionResponse *msg)
+{
+    const CachedDecision *decision = decision_cache->lookup(key);
+
+    measure_declared_quantity(decision_cache_hit, decision != nullptr);
+    if (decision == nullptr){
+        decision_cache_misses++;
+        return false;
+    }
+
+    decision_cache_hits++;
+    answered_by_cache = true;
+    measure_declared_quantity(decision_cache_time_saved, agent_call_time);
+    msg->setSend_message(decision->send_message);
+    msg->setSelect_power_source((SelectPowerSource) decision->power_source);
+    msg->setQueue(decision->queue);
+    msg->setMsg_to_send(decision->msg_to_send);
+
+    EV_DEBUG << "Decision cache hit for state " << key << endl;
+    return true;
+}
+
+void AgentClientPybind::ask_agent(float reward, uint64_t key, ActionResponse *msg)
+{
+    py::object action_bean;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed;
+
+    action_bean = get_action_from_buffer(reward, answered_by_cache);
+    answered_by_cache = false;
+    action_bean_to_msg(action_bean, msg);
+    if (decision_cache == nullptr)
+        return;
+
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    agent_call_time = decision_cache_misses == 1 ? elapsed
+     : (1 - EWMA_ALPHA_DEFAULT) * agent_call_time + EWMA_ALPHA_DEFAULT * elapsed;
+
+    // the call may have trained the agent, invalidating the cached decisions
+    if (decision_cache->sync_generation(policy_generation[0]))
+        decision_cache_invalidations++;
+    if (action_bean.attr("cacheable").cast<bool>())
+        decision_cache->insert(key, {msg->getSend_message(),
+         (int) msg->getSelect_power_source(), msg->getQueue(), msg->getMsg_to_send()});
 }
 
 void AgentClientPybind::handleActionRequest(ActionRequest *msg)
 {    
-    py::object state_bean = py::module_::import("agent").attr("StateBean")();
-    py::object reward_bean = py::module_::import("agent").attr("RewardBean")();
-    py::object action_bean;
-    py::object current_action_bean;
     ActionResponse *response;
+    uint64_t key = 0;
 
     EV_DEBUG << "Agent client received action request" << endl;
 
-    // converts request params in state and reward beans
-    state_msg_to_bean(msg->getState(), state_bean);
-    reward_msg_to_bean(msg->getReward(), reward_bean);
-    // interrogates agent for the next action
-    action_bean = this->agent.attr("get_action")(state_bean, reward_bean);
+    // writes the state in the buffer shared with the agent, then interrogates
+    // the agent for the next action with a single call, unless the decision
+    // for the state is cached
+    state_msg_to_buffer(msg->getState());
+    response = new ActionResponse();
+    if (decision_cache != nullptr)
+        key = state_key();
+    if (decision_cache == nullptr || !answer_from_cache(key, response)){
+        ask_agent(msg->getReward().getValue(), key, response);
+
+        // prints output of the agent to console, if anybody is listening.
+        // Otherwise the output stays in the ring buffer until finish()
+        if (debug_log_enabled())
+            log_agent_output();
+    }
+
+    // sends the action back to the controller
+    this->send(response, "port$o");
+}
+
+bool AgentClientPybind::debug_log_enabled()
+{
+    return COMPILETIME_LOG_PREDICATE(this, LOGLEVEL_DEBUG, nullptr)
+     && cLog::runtimeLogPredicate(this, LOGLEVEL_DEBUG, nullptr);
+}
 
-    // prints output of the agent to console
+void AgentClientPybind::log_agent_output()
+{
     EV_DEBUG << "Agent output:" << endl;
     EV_DEBUG << PythonInterpreter::getInstance()->pyStdStreamsRedirect->outString();
     EV_DEBUG << "end of agent output" << endl;
-    // converts the action bean in a ActionResponse message and send it
-    // back to the controller
-    response = new ActionResponse();
-    action_bean_to_msg(action_bean, response);
-    this->send(response, "port$o");
+}
+
+void AgentClientPybind::init_agent_output()
+{
+    OutputRing &out_ring = PythonInterpreter::getInstance()->pyStdStreamsRedirect->outRing();
+    OutputDropPolicy drop_policy;
+    size_t capacity = par("agent_output_buffer_size").intValue();
+
+    if (!parse_output_drop_policy(par("agent_output_drop_policy").stringValue(), drop_policy))
+        throw cRuntimeError("Unknown agent output drop policy %s",
+         par("agent_output_drop_policy").stringValue());
+
+    // the interpreter, and so the ring, outlives the runs of a sweep
+    if (agent_output_owner == nullptr){
+        agent_output_owner = this;
+        out_ring.resetDroppedBytes();
+    }
+
+    // the ring is shared by all the agent clients, the first one sets it up
+    out_ring.setDropPolicy(drop_policy);
+    if (out_ring.getCapacity() != capacity && out_ring.empty())
+        out_ring.setCapacity(capacity);
 }
 
 void AgentClientPybind::initialize()
 {
     AgentClient::initialize();
     
+    init_quantity_signals();
     init_module_params();
     init_python_interface();
 
@@ -72,6 +167,9 @@ void AgentClientPybind::initialize()
 void AgentClientPybind::init_module_params()
 {
     num_of_queues = par("num_of_queues").intValue();
+    use_decision_cache = par("use_decision_cache").boolValue();
+    decision_cache_size = par("decision_cache_size").intValue();
+    agent_output_file = par("agent_output_file").stringValue();
 }
 
 void AgentClientPybind::init_python_interface()
@@ -79,6 +177,8 @@ void AgentClientPybind::init_python_interface()
     PythonInterpreter::getInstance()->use();
     py::object agent_facade_bean;
 
+    init_agent_output();
+
     // preloads the agent module to speed up simulation execution
     // (simulation startup will be slower)
     agent_facade_bean = py::module_::import("agent").attr("AgentFacadeBean")();
@@ -86,10 +186,76 @@ void AgentClientPybind::init_python_interface()
     agent_facade_bean.attr("n_queues") = num_of_queues;
     this->agent = py::module_::import("agent").attr("AgentFacade")(agent_facade_bean);
 
+    // exposes the state buffer once as a NumPy view. The capsule base prevents
+    // NumPy from copying the data, whose lifetime is managed by this module
+    state_buffer.assign(1 + num_of_queues + 1, 0);
+    state_view = py::array_t<float>((py::ssize_t) state_buffer.size(), state_buffer.data(),
+     py::capsule(state_buffer.data(), [](void *) {}));
+    this->agent.attr("attach_state_buffer")(state_view);
+    get_action_from_buffer = this->agent.attr("get_action_from_buffer");
+
+    if (use_decision_cache){
+        decision_cache = new DecisionCache(decision_cache_size);
+        state_levels.resize(state_buffer.size());
+        policy_generation.assign(1, 0);
+        policy_generation_view = py::array_t<uint64_t>(1, policy_generation.data(),
+         py::capsule(policy_generation.data(), [](void *) {}));
+        this->agent.attr("attach_policy_generation")(policy_generation_view);
+    }
+
+}
+
+void AgentClientPybind::finish()
+{
+    const char *export_weights = par("export_weights").stringValue();
+
+    if (decision_cache != nullptr){
+        recordScalar("decision_cache_hits", decision_cache_hits);
+        recordScalar("decision_cache_misses", decision_cache_misses);
+        recordScalar("decision_cache_invalidations", decision_cache_invalidations);
+    }
+
+    if (export_weights[0] != '\0'){
+        this->agent.attr("export_weights")(export_weights);
+        EV_INFO << "Agent weights exported to " << export_weights << endl;
+    }
+
+    finish_agent_output();
+}
+
+void AgentClientPybind::finish_agent_output()
+{
+    OutputRing &out_ring = PythonInterpreter::getInstance()->pyStdStreamsRedirect->outRing();
+    std::string out_string;
+    std::ofstream out_file;
+
+    // the count is the same for every client, so it is recorded once
+    if (agent_output_owner == this)
+        recordScalar("agent_output_dropped_bytes", out_ring.getDroppedBytes());
+
+    // drains whatever was not printed in bulk
+    if (agent_output_file[0] != '\0'){
+        out_ring.drain(out_string);
+        out_file.open(agent_output_file, std::ios::app);
+        if (!out_file)
+            throw cRuntimeError("Cannot open agent output file %s", agent_output_file);
+        out_file << out_string;
+    }
+    else if (debug_log_enabled()){
+        log_agent_output();
+    }
 }
 
 AgentClientPybind::~AgentClientPybind()
 {
+    delete decision_cache;
+
+    if (agent_output_owner == this)
+        agent_output_owner = nullptr;
+
+    this->policy_generation_view.release();
+    this->get_action_from_buffer.release();
+    this->state_view.release();
     this->agent.release();
     
     // unregisters from the python interpreter
@@ -3,24 +3,93 @@
 
 #include "agent_client.h"
 #include <pybind11/embed.h>
+#include <pybind11/numpy.h>
 #include "cpp_visibility_tools.h"
 #include "ActionResponse_m.h"
+#include "decision_cache.h"
+#include "statistics.h"
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace py = pybind11;
 
+#define AGENT_CLIENT_PYBIND_QUANTITIES(X)\
+    X(decision_cache_hit)\
+    X(decision_cache_time_saved)
+
 class DLL_LOCAL AgentClientPybind : public AgentClient {
     protected:
         py::object agent;
+        // bound AgentFacade.get_action_from_buffer, resolved once
+        py::object get_action_from_buffer;
 
         size_t num_of_queues;
+
+        /**
+         * State of the node laid out as in StateBean.observation_spec:
+         * [energy, q_1, ..., q_n, charge_rate].
+         * The buffer is shared with the agent through a NumPy view, so each
+         * request only writes it in place.
+        */
+        std::vector<float> state_buffer;
+        py::array_t<float> state_view;
+
+        /**
+         * Decision cache state:
+         * repeated states are answered without entering Python, as long as the
+         * agent policy does not change. The agent bumps policy_generation
+         * whenever training updates its weights.
+        */
+        DecisionCache *decision_cache = nullptr;
+        std::vector<uint32_t> state_levels;
+        std::vector<uint64_t> policy_generation;
+        py::array_t<uint64_t> policy_generation_view;
+        // set when requests were answered by the cache since the last call to
+        // the agent, so the reward it gets does not belong to its last action
+        bool answered_by_cache = false;
+        // wall clock seconds of a call to the agent, averaged
+        double agent_call_time = 0;
+        long decision_cache_hits = 0;
+        long decision_cache_misses = 0;
+        long decision_cache_invalidations = 0;
+        /* Decision cache state (END)*/
+
+        declare_quantities(AGENT_CLIENT_PYBIND_QUANTITIES)
+
+        /**
+         * The agent output ring is shared by all the clients of the process.
+         * The first client initialized in a run owns it for that run: it
+         * resets its counters and records its statistics.
+        */
+        static AgentClientPybind *agent_output_owner;
+
+        /**
+         * Module parameters:
+        */
+        bool use_decision_cache;
+        int decision_cache_size;
+        const char *agent_output_file;
+        /* Module parameters (END)*/
         
-        void state_msg_to_bean(const NodeStateMsg &msg, py::object bean);
-        void reward_msg_to_bean(const RewardMsg &reward, py::object bean);
+        void state_msg_to_buffer(const NodeStateMsg &msg);
         void action_bean_to_msg(py::object bean, ActionResponse *msg);  
+        uint64_t state_key();
+        bool answer_from_cache(uint64_t key, ActionResponse *msg);
+        void ask_agent(float reward, uint64_t key, ActionResponse *msg);
+
+        /**
+         * Returns whether debug messages of this module reach the log, so
+         * that the agent output is drained only when it would be printed.
+        */
+        bool debug_log_enabled();
+        void log_agent_output();
+        void init_agent_output();
+        void finish_agent_output();
         
         void handleActionRequest(ActionRequest *msg) override;
         void initialize() override;
+        void finish() override;
         
         void init_module_params();
         void init_python_interface();
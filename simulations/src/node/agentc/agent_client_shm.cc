@@ -0,0 +1,135 @@
+#include "agent_client_shm.h"
+#include <chrono>
+#include <thread>
+
+Define_Module(AgentClientShm);
+
+// spins before yielding the cpu while waiting for the server
+#define SHM_AGENT_SPIN_ITERATIONS 1024
+
+void AgentClientShm::state_msg_to_request(const ActionRequest *msg, ShmActionRequest &request)
+{
+    const NodeStateMsg &state = msg->getState();
+    size_t num_queue_states = state.getQueue_pop_percentageArraySize();
+
+    if (num_queue_states != num_of_queues)
+        EV_WARN << "State has " << num_queue_states << " queues instead of "
+         << num_of_queues << ", it will be padded with zeros or truncated" << endl;
+
+    request.reward = msg->getReward().getValue();
+    request.energy = state.getEnergy_percentage();
+    request.charge_rate = state.getCharge_rate_percentage();
+    request.num_queues = num_of_queues;
+    for (size_t i = 0; i < num_of_queues; i ++){
+        request.queue_occ[i] = i < num_queue_states ? state.getQueue_pop_percentage(i) : 0;
+    }
+}
+
+void AgentClientShm::response_to_action_msg(const ShmActionResponse &response,
+ ActionResponse *msg)
+{
+    msg->setSend_message(response.send_message);
+    msg->setSelect_power_source((SelectPowerSource) response.power_source);
+    msg->setQueue(response.queue);
+    msg->setMsg_to_send(response.msg_to_send);
+}
+
+void AgentClientShm::wait_response(uint64_t seq, ShmActionResponse &response)
+{
+    ShmAgentChannel &ch = segment->channels[channel];
+    auto deadline = std::chrono::steady_clock::now()
+     + std::chrono::duration<double>(response_timeout);
+
+    for (unsigned int i = 0; ; i ++){
+        if (ch.responses.pop(response)){
+            if (response.seq == seq)
+                return;
+            EV_WARN << "Discarding stale response " << response.seq
+             << " while waiting for " << seq << endl;
+            continue;
+        }
+        if (i >= SHM_AGENT_SPIN_ITERATIONS){
+            if (std::chrono::steady_clock::now() > deadline)
+                throw cRuntimeError("No response from the agent server within %gs",
+                 response_timeout);
+            std::this_thread::yield();
+        }
+    }
+}
+
+void AgentClientShm::handleActionRequest(ActionRequest *msg)
+{
+    ShmActionRequest request;
+    ShmActionResponse response;
+    ActionResponse *action_msg;
+
+    EV_DEBUG << "Agent client received action request" << endl;
+
+    request.seq = next_seq++;
+    state_msg_to_request(msg, request);
+    // the client never has more than one request in flight, so the ring
+    // can't be full
+    if (!segment->channels[channel].requests.push(request))
+        throw cRuntimeError("Agent server request ring is full");
+
+    wait_response(request.seq, response);
+
+    action_msg = new ActionResponse();
+    response_to_action_msg(response, action_msg);
+    this->send(action_msg, "port$o");
+}
+
+void AgentClientShm::initialize()
+{
+    AgentClient::initialize();
+
+    init_module_params();
+    init_channel();
+}
+
+void AgentClientShm::init_module_params()
+{
+    num_of_queues = par("num_of_queues").intValue();
+    shm_name = par("shm_name").stringValue();
+    response_timeout = par("response_timeout").doubleValueInUnit("s");
+
+    if (num_of_queues > SHM_AGENT_MAX_QUEUES)
+        throw cRuntimeError("Shared memory agent client supports at most %d queues",
+         SHM_AGENT_MAX_QUEUES);
+}
+
+void AgentClientShm::init_channel()
+{
+    string error;
+
+    segment = shm_agent_open(shm_name, error);
+    if (segment == nullptr)
+        throw cRuntimeError("Cannot connect to the agent server (%s): is it running?",
+         error.c_str());
+
+    channel = shm_agent_claim_channel(segment, num_of_queues, implementation);
+    if (channel < 0)
+        throw cRuntimeError("All the %d channels of the agent server are in use",
+         (int) segment->num_channels);
+
+    EV_DEBUG << "Agent client connected to " << shm_name << " on channel "
+     << channel << endl;
+}
+
+void AgentClientShm::finish()
+{
+    if (segment != nullptr && channel >= 0){
+        shm_agent_release_channel(segment, channel);
+        channel = -1;
+    }
+}
+
+AgentClientShm::~AgentClientShm()
+{
+    if (segment != nullptr){
+        // finish() is not called if the simulation ends with an error
+        if (channel >= 0)
+            shm_agent_release_channel(segment, channel);
+        shm_agent_close(segment);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef AGENT_CLIENT_SHM_H
+#define AGENT_CLIENT_SHM_H
+
+#include "agent_client.h"
+#include "shm_ring.h"
+#include "ActionResponse_m.h"
+#include <cstdint>
+
+/**
+ * Agent client that forwards action requests to a local agent server process
+ * through a shared memory channel (see shm_ring.h), instead of embedding the
+ * Python interpreter.
+ *
+ * The server must be started before the simulation, and can serve several
+ * simulation runs at the same time. Requests are still answered synchronously:
+ * the client waits for the response of the server before going on.
+*/
+class AgentClientShm : public AgentClient {
+    protected:
+        ShmAgentSegment *segment = nullptr;
+        int channel = -1;
+        uint64_t next_seq = 0;
+
+        /**
+         * Module parameters:
+        */
+        size_t num_of_queues;
+        const char *shm_name;
+        // wall clock time to wait for a response before giving up
+        double response_timeout;
+        /* Module parameters (END)*/
+
+        void state_msg_to_request(const ActionRequest *msg, ShmActionRequest &request);
+        void response_to_action_msg(const ShmActionResponse &response, ActionResponse *msg);
+        void wait_response(uint64_t seq, ShmActionResponse &response);
+
+        void handleActionRequest(ActionRequest *msg) override;
+        void initialize() override;
+        void finish() override;
+
+        void init_module_params();
+        void init_channel();
+    public:
+        ~AgentClientShm();
+};
+
+#endif // AGENT_CLIENT_SHM_H
@@ -0,0 +1,100 @@
+#ifndef DECISION_CACHE_H
+#define DECISION_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+using namespace std;
+
+// quantized features packed in a key without hashing, each one takes 4 bits
+#define DECISION_CACHE_EXACT_FEATURES 16
+
+struct CachedDecision {
+  bool send_message;
+  int power_source;
+  int queue;
+  int msg_to_send;
+};
+
+/**
+ * Cache of the decisions of a greedy policy, keyed by the quantized state.
+ *
+ * The cache is valid only as long as the policy does not change: the owner of
+ * the policy bumps a generation counter whenever it updates the weights, and
+ * the cache is cleared as soon as it sees a new generation.
+*/
+class DecisionCache {
+
+  protected:
+    unordered_map<uint64_t, CachedDecision> decisions;
+    size_t capacity;
+    uint64_t generation = 0;
+
+  public:
+    DecisionCache(size_t capacity) : capacity(capacity) {
+      decisions.reserve(capacity);
+    }
+
+    /**
+     * Returns the key of a state made of num_levels quantized features, each
+     * one in [0, 16).
+     * States with up to DECISION_CACHE_EXACT_FEATURES features are packed as they
+     * are, so their keys never collide. Longer states are hashed to 64 bits.
+    */
+    static uint64_t key(const uint32_t *levels, size_t num_levels) {
+      uint64_t key = 0;
+      uint64_t word;
+
+      if (num_levels <= DECISION_CACHE_EXACT_FEATURES){
+        for (size_t i = 0; i < num_levels; i ++){
+          key = (key << 4) | levels[i];
+        }
+        return key;
+      }
+
+      for (size_t i = 0; i < num_levels; i += DECISION_CACHE_EXACT_FEATURES){
+        word = 0;
+        for (size_t j = i; j < num_levels && j < i + DECISION_CACHE_EXACT_FEATURES; j ++){
+          word = (word << 4) | levels[j];
+        }
+        // splitmix64 finalizer
+        key ^= word + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2);
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+      }
+      return key;
+    }
+
+    /**
+     * Clears the cache if the policy generation changed.
+     * Returns whether the cache was cleared.
+    */
+    bool sync_generation(uint64_t generation) {
+      if (generation == this->generation)
+        return false;
+      this->generation = generation;
+      decisions.clear();
+      return true;
+    }
+
+    const CachedDecision *lookup(uint64_t key) const {
+      auto it = decisions.find(key);
+
+      return it == decisions.end() ? nullptr : &it->second;
+    }
+
+    void insert(uint64_t key, const CachedDecision &decision) {
+      // the policy usually visits few states, so a full cache is just reset
+      if (decisions.size() >= capacity)
+        decisions.clear();
+      decisions[key] = decision;
+    }
+
+    size_t size() const {
+      return decisions.size();
+    }
+};
+
+#endif // DECISION_CACHE_H
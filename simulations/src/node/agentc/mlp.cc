@@ -0,0 +1,256 @@
+#include "mlp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MLP_AVX2
+#include <immintrin.h>
+#endif
+
+void dense_forward_scalar(const DenseLayer &layer, const float *in, float *out)
+{
+    for (uint32_t o = 0; o < layer.num_outputs; o ++){
+        const float *w = layer.weights.data() + (size_t) o * layer.row_stride;
+        float sum = layer.biases[o];
+
+        for (uint32_t i = 0; i < layer.num_inputs; i ++){
+            sum += w[i] * in[i];
+        }
+        out[o] = sum;
+    }
+}
+
+#ifdef MLP_AVX2
+
+__attribute__((target("avx2,fma")))
+static inline float hsum(__m256 v)
+{
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    return _mm_cvtss_f32(lo);
+}
+
+/**
+ * Blocks of 4 output rows share the loads of the input, and the input is
+ * walked in tiles of MLP_INPUT_TILE floats. Rows are padded with zeros to a
+ * multiple of 8 floats, and so is the input, so there are no tails.
+*/
+__attribute__((target("avx2,fma")))
+static void dense_forward_avx2(const DenseLayer &layer, const float *in, float *out)
+{
+    uint32_t num_outputs = layer.num_outputs;
+    uint32_t stride = layer.row_stride;
+    const float *weights = layer.weights.data();
+    uint32_t o;
+
+    for (o = 0; o < num_outputs; o ++){
+        out[o] = layer.biases[o];
+    }
+
+    for (uint32_t tile = 0; tile < stride; tile += MLP_INPUT_TILE){
+        uint32_t tile_end = std::min(tile + MLP_INPUT_TILE, stride);
+
+        for (o = 0; o + 4 <= num_outputs; o += 4){
+            const float *w0 = weights + (size_t) o * stride;
+            const float *w1 = w0 + stride;
+            const float *w2 = w1 + stride;
+            const float *w3 = w2 + stride;
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            __m256 acc2 = _mm256_setzero_ps();
+            __m256 acc3 = _mm256_setzero_ps();
+
+            for (uint32_t i = tile; i < tile_end; i += 8){
+                __m256 x = _mm256_loadu_ps(in + i);
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + i), x, acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + i), x, acc1);
+                acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + i), x, acc2);
+                acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + i), x, acc3);
+            }
+            out[o] += hsum(acc0);
+            out[o + 1] += hsum(acc1);
+            out[o + 2] += hsum(acc2);
+            out[o + 3] += hsum(acc3);
+        }
+        // remaining rows
+        for (; o < num_outputs; o ++){
+            const float *w = weights + (size_t) o * stride;
+            __m256 acc = _mm256_setzero_ps();
+
+            for (uint32_t i = tile; i < tile_end; i += 8){
+                acc = _mm256_fmadd_ps(_mm256_loadu_ps(w + i), _mm256_loadu_ps(in + i), acc);
+            }
+            out[o] += hsum(acc);
+        }
+    }
+}
+
+static bool cpu_has_avx2()
+{
+    static bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has_avx2;
+}
+
+#endif // MLP_AVX2
+
+void dense_forward(const DenseLayer &layer, const float *in, float *out)
+{
+#ifdef MLP_AVX2
+    if (cpu_has_avx2()){
+        dense_forward_avx2(layer, in, out);
+        return;
+    }
+#endif
+    dense_forward_scalar(layer, in, out);
+}
+
+static void activate(MlpActivation activation, float *values, uint32_t size)
+{
+    float max_value;
+    float sum = 0;
+
+    switch (activation){
+        case MLP_RELU:
+            for (uint32_t i = 0; i < size; i ++) values[i] = std::max(values[i], 0.0f);
+            break;
+        case MLP_TANH:
+            for (uint32_t i = 0; i < size; i ++) values[i] = tanhf(values[i]);
+            break;
+        case MLP_SIGMOID:
+            for (uint32_t i = 0; i < size; i ++) values[i] = 1 / (1 + expf(-values[i]));
+            break;
+        case MLP_SOFTMAX:
+            max_value = *std::max_element(values, values + size);
+            for (uint32_t i = 0; i < size; i ++){
+                values[i] = expf(values[i] - max_value);
+                sum += values[i];
+            }
+            for (uint32_t i = 0; i < size; i ++) values[i] /= sum;
+            break;
+        case MLP_LINEAR:
+            break;
+    }
+}
+
+void Mlp::add_layer(DenseLayer &&layer)
+{
+    size_t size = layer.row_stride;
+
+    size = std::max<size_t>(size, layer.num_outputs + MLP_ROW_ALIGN);
+    for (vector<float> &buffer : buffers){
+        // padding of the inputs of the next layer must be zero
+        if (buffer.size() < size)
+            buffer.resize(size, 0);
+    }
+    layers.push_back(std::move(layer));
+}
+
+const float *Mlp::forward(const float *input)
+{
+    const DenseLayer &first = layers.front();
+    float *in = buffers[0].data();
+    float *out = buffers[1].data();
+
+    // copies the input to get the zero padding the layer expects
+    std::copy(input, input + first.num_inputs, in);
+    std::fill(in + first.num_inputs, in + first.row_stride, 0.0f);
+
+    for (const DenseLayer &layer : layers){
+        dense_forward(layer, in, out);
+        activate(activation, out, layer.num_outputs);
+        // pads the outputs with zeros, since they are the inputs of the next layer.
+        // The buffer may hold stale values of a previous, longer layer
+        std::fill(out + layer.num_outputs, out + (layer.num_outputs + MLP_ROW_ALIGN - 1)
+         / MLP_ROW_ALIGN * MLP_ROW_ALIGN, 0.0f);
+        std::swap(in, out);
+    }
+
+    return in;
+}
+
+int Mlp::argmax(const float *input)
+{
+    const float *q_values = forward(input);
+
+    return std::max_element(q_values, q_values + getNumOutputs()) - q_values;
+}
+
+bool load_mlp_weights(const string &path, MlpWeights &weights, string &error)
+{
+    unique_ptr<FILE, int (*)(FILE *)> file(fopen(path.c_str(), "rb"), fclose);
+    uint32_t header[5];
+    uint32_t num_layers;
+    uint32_t shape[2];
+
+    if (!file){
+        error = "cannot open " + path;
+        return false;
+    }
+    if (fread(header, sizeof(uint32_t), 5, file.get()) != 5
+     || header[0] != MLP_WEIGHTS_MAGIC || header[1] != MLP_WEIGHTS_VERSION){
+        error = path + " is not a weights file of version " + to_string(MLP_WEIGHTS_VERSION);
+        return false;
+    }
+    if (header[2] != MLP_LAYOUT_FLAT && header[2] != MLP_LAYOUT_DEEP){
+        error = "unknown layout " + to_string(header[2]);
+        return false;
+    }
+    if (header[3] < MLP_RELU || header[3] > MLP_SOFTMAX){
+        error = "unknown activation " + to_string(header[3]);
+        return false;
+    }
+
+    weights.layout = (MlpLayout) header[2];
+    weights.networks.clear();
+    for (uint32_t n = 0; n < header[4]; n ++){
+        Mlp network((MlpActivation) header[3]);
+        uint32_t expected_inputs = 0;
+
+        if (fread(&num_layers, sizeof(uint32_t), 1, file.get()) != 1 || num_layers == 0){
+            error = "truncated network " + to_string(n);
+            return false;
+        }
+        for (uint32_t l = 0; l < num_layers; l ++){
+            DenseLayer layer;
+
+            if (fread(shape, sizeof(uint32_t), 2, file.get()) != 2){
+                error = "truncated layer " + to_string(l) + " of network " + to_string(n);
+                return false;
+            }
+            layer.num_inputs = shape[0];
+            layer.num_outputs = shape[1];
+            if (l > 0 && layer.num_inputs != expected_inputs){
+                error = "layer " + to_string(l) + " of network " + to_string(n)
+                 + " does not match the previous one";
+                return false;
+            }
+            expected_inputs = layer.num_outputs;
+            layer.row_stride = (layer.num_inputs + MLP_ROW_ALIGN - 1) / MLP_ROW_ALIGN
+             * MLP_ROW_ALIGN;
+            layer.weights.assign((size_t) layer.num_outputs * layer.row_stride, 0);
+            layer.biases.resize(layer.num_outputs);
+            for (uint32_t o = 0; o < layer.num_outputs; o ++){
+                if (fread(layer.weights.data() + (size_t) o * layer.row_stride, sizeof(float),
+                 layer.num_inputs, file.get()) != layer.num_inputs){
+                    error = "truncated weights of network " + to_string(n);
+                    return false;
+                }
+            }
+            if (fread(layer.biases.data(), sizeof(float), layer.num_outputs, file.get())
+             != layer.num_outputs){
+                error = "truncated biases of network " + to_string(n);
+                return false;
+            }
+            network.add_layer(std::move(layer));
+        }
+        weights.networks.push_back(std::move(network));
+    }
+
+    return true;
+}
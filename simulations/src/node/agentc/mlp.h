@@ -0,0 +1,113 @@
+#ifndef MLP_H
+#define MLP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define MLP_WEIGHTS_MAGIC 0x4d4c5057
+#define MLP_WEIGHTS_VERSION 1
+
+// dense layers process inputs in tiles of this many floats, so that a tile of
+// the input stays in L1 while all the output rows go through it
+#define MLP_INPUT_TILE 512
+// rows of the weight matrix are padded to a multiple of this many floats
+#define MLP_ROW_ALIGN 8
+
+/**
+ * Decision tree layout the networks were exported from, see
+ * AgentFacade._init_decision_tree.
+*/
+enum MlpLayout : uint32_t {
+  MLP_LAYOUT_FLAT = 0,
+  // root, choose queue and choose power source networks
+  MLP_LAYOUT_DEEP = 1
+};
+
+// same values of ActivationEnum in agent_factory.py
+enum MlpActivation : uint32_t {
+  MLP_RELU = 1,
+  MLP_TANH = 2,
+  MLP_SIGMOID = 3,
+  MLP_LINEAR = 4,
+  MLP_SOFTMAX = 5
+};
+
+/**
+ * Fully connected layer, followed by the activation of the network.
+ * Weights are stored row major, one padded row for each output.
+*/
+struct DenseLayer {
+  uint32_t num_inputs;
+  uint32_t num_outputs;
+  // floats between two rows of weights
+  uint32_t row_stride;
+  vector<float> weights;
+  vector<float> biases;
+};
+
+/**
+ * Multilayer perceptron running greedy inference of an exported Q-network.
+*/
+class Mlp {
+
+  protected:
+    vector<DenseLayer> layers;
+    MlpActivation activation;
+    // ping-pong buffers for the layer outputs
+    vector<float> buffers[2];
+
+  public:
+    Mlp(MlpActivation activation) : activation(activation) {}
+
+    void add_layer(DenseLayer &&layer);
+
+    uint32_t getNumInputs() const {
+      return layers.front().num_inputs;
+    }
+
+    uint32_t getNumOutputs() const {
+      return layers.back().num_outputs;
+    }
+
+    /**
+     * Computes the Q-values of the input, returning a pointer to them.
+     * The pointer is valid until the next call.
+    */
+    const float *forward(const float *input);
+
+    /**
+     * Returns the index of the max Q-value of the input, the first one on ties.
+    */
+    int argmax(const float *input);
+};
+
+/**
+ * Networks exported by agent/export_weights.py.
+ *
+ * File layout (little endian):
+ *  uint32 magic, version, layout, activation, num_networks
+ *  for each network: uint32 num_layers
+ *   for each layer: uint32 num_inputs, num_outputs,
+ *    float32 weights[num_outputs][num_inputs], float32 biases[num_outputs]
+*/
+struct MlpWeights {
+  MlpLayout layout;
+  vector<Mlp> networks;
+};
+
+/**
+ * Loads the networks from the file at path.
+ * Returns false and writes the reason to error on failure.
+*/
+bool load_mlp_weights(const string &path, MlpWeights &weights, string &error);
+
+/**
+ * Computes out = W * in + b for a layer, using AVX2 when the CPU supports it.
+*/
+void dense_forward(const DenseLayer &layer, const float *in, float *out);
+void dense_forward_scalar(const DenseLayer &layer, const float *in, float *out);
+
+#endif // MLP_H
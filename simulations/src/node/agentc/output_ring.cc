@@ -0,0 +1,84 @@
+#include "output_ring.h"
+#include <algorithm>
+#include <cstring>
+
+OutputRing::OutputRing(size_t capacity, OutputDropPolicy drop_policy)
+{
+    this->drop_policy = drop_policy;
+    setCapacity(capacity);
+}
+
+void OutputRing::setCapacity(size_t capacity)
+{
+    buffer.assign(capacity, 0);
+    clear();
+}
+
+void OutputRing::copy_in(const char *data, size_t size)
+{
+    size_t tail = (head + length) % buffer.size();
+    size_t first = min(size, buffer.size() - tail);
+
+    memcpy(buffer.data() + tail, data, first);
+    memcpy(buffer.data(), data + first, size - first);
+    length += size;
+}
+
+size_t OutputRing::write(const char *data, size_t size)
+{
+    size_t capacity = buffer.size();
+    size_t free_space = capacity - length;
+    size_t overflow;
+
+    if (capacity == 0){
+        dropped_bytes += size;
+        return 0;
+    }
+
+    if (size <= free_space){
+        copy_in(data, size);
+        return size;
+    }
+
+    if (drop_policy == OutputDropPolicy::DROP_NEWEST){
+        dropped_bytes += size - free_space;
+        copy_in(data, free_space);
+        return free_space;
+    }
+
+    // DROP_OLDEST: only the last capacity bytes of data can survive
+    if (size >= capacity){
+        dropped_bytes += length + size - capacity;
+        clear();
+        copy_in(data + size - capacity, capacity);
+        return size;
+    }
+    overflow = size - free_space;
+    head = (head + overflow) % capacity;
+    length -= overflow;
+    dropped_bytes += overflow;
+    copy_in(data, size);
+    return size;
+}
+
+void OutputRing::drain(string &out)
+{
+    size_t first = min(length, buffer.size() - head);
+
+    out.append(buffer.data() + head, first);
+    out.append(buffer.data(), length - first);
+    clear();
+}
+
+bool parse_output_drop_policy(const char *name, OutputDropPolicy &drop_policy)
+{
+    if (strcmp(name, "oldest") == 0){
+        drop_policy = OutputDropPolicy::DROP_OLDEST;
+        return true;
+    }
+    if (strcmp(name, "newest") == 0){
+        drop_policy = OutputDropPolicy::DROP_NEWEST;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,99 @@
+#ifndef OUTPUT_RING_H
+#define OUTPUT_RING_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum class OutputDropPolicy {
+  // old output is overwritten by the new one
+  DROP_OLDEST,
+  // new output is discarded until the buffer is drained
+  DROP_NEWEST
+};
+
+/**
+ * Bounded byte ring buffer collecting the output of the agent.
+ *
+ * Writes never allocate: when the buffer is full, bytes are dropped according
+ * to the drop policy and counted, so the output can be drained lazily, only
+ * when somebody is going to read it.
+*/
+class OutputRing {
+
+  protected:
+    vector<char> buffer;
+    // index of the first byte to be drained
+    size_t head = 0;
+    size_t length = 0;
+    OutputDropPolicy drop_policy;
+    size_t dropped_bytes = 0;
+
+    void copy_in(const char *data, size_t size);
+
+  public:
+    OutputRing(size_t capacity, OutputDropPolicy drop_policy);
+
+    /**
+     * Resizes the buffer, discarding its content.
+    */
+    void setCapacity(size_t capacity);
+
+    size_t getCapacity() const {
+      return buffer.size();
+    }
+
+    void setDropPolicy(OutputDropPolicy drop_policy) {
+      this->drop_policy = drop_policy;
+    }
+
+    OutputDropPolicy getDropPolicy() const {
+      return drop_policy;
+    }
+
+    /**
+     * Returns the number of bytes dropped since the buffer was created
+     * or the count was last reset.
+    */
+    size_t getDroppedBytes() const {
+      return dropped_bytes;
+    }
+
+    void resetDroppedBytes() {
+      dropped_bytes = 0;
+    }
+
+    size_t size() const {
+      return length;
+    }
+
+    bool empty() const {
+      return length == 0;
+    }
+
+    /**
+     * Appends size bytes to the buffer, dropping bytes if it is full.
+     * Returns the number of bytes accepted.
+    */
+    size_t write(const char *data, size_t size);
+
+    /**
+     * Appends the content of the buffer to out and empties the buffer.
+    */
+    void drain(string &out);
+
+    void clear() {
+      head = 0;
+      length = 0;
+    }
+};
+
+/**
+ * Parses a drop policy name, "oldest" or "newest".
+ * Returns false if the name is unknown.
+*/
+bool parse_output_drop_policy(const char *name, OutputDropPolicy &drop_policy);
+
+#endif // OUTPUT_RING_H
@@ -3,6 +3,17 @@
 
 PythonInterpreter* PythonInterpreter::instance = nullptr;
 
+// file-like object replacing sys.stdout and sys.stderr
+PYBIND11_EMBEDDED_MODULE(agentc_output, m) {
+    py::class_<OutputRing>(m, "OutputRing")
+        .def("write", [](OutputRing &ring, const std::string &text) {
+            ring.write(text.data(), text.size());
+            return text.size();
+        })
+        .def("flush", [](OutputRing &) {})
+        .def("isatty", [](OutputRing &) { return false; });
+}
+
 PythonInterpreter::PythonInterpreter(){
     this->python_ref_count = 0;
 }
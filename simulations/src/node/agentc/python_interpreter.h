@@ -3,32 +3,42 @@
 
 #include <pybind11/embed.h>
 #include "cpp_visibility_tools.h"
+#include "output_ring.h"
+#include <string>
 
 namespace py = pybind11;
 
+// capacity of the buffer of the agent output, until an agent client sets it
+#define PY_OUTPUT_RING_DEFAULT_CAPACITY 65536
+
 // https://github.com/pybind/pybind11/issues/1622#issuecomment-452718093
+// Python stdout and stderr are replaced by a native ring buffer, see the
+// agentc_output module in python_interpreter.cc, so writes of the agent do
+// not go through a StringIO and the output is only copied when drained.
 class DLL_LOCAL PyStdStreamsRedirect {
     py::object _stdout;
     py::object _stderr;
+    OutputRing _out_ring;
     py::object _out_buffer;
 public:
-    PyStdStreamsRedirect() {
+    PyStdStreamsRedirect() : _out_ring(PY_OUTPUT_RING_DEFAULT_CAPACITY, OutputDropPolicy::DROP_OLDEST) {
         auto sysm = py::module::import("sys");
         _stdout = sysm.attr("stdout");
         _stderr = sysm.attr("stderr");
-        auto stringio = py::module::import("io").attr("StringIO");
-        _out_buffer = stringio();  // Other filelike object can be used here as well, such as objects created by pybind11
+        // the module registers the type of the ring, which stays owned by C++
+        py::module::import("agentc_output");
+        _out_buffer = py::cast(&_out_ring, py::return_value_policy::reference);
         // stderr and stdout buffers are merged
         sysm.attr("stdout") = _out_buffer;
         sysm.attr("stderr") = _out_buffer;
     }
+    OutputRing &outRing() {
+        return _out_ring;
+    }
     std::string outString() {
-        py::str out_string;
-        
-        _out_buffer.attr("seek")(0);
-        out_string = py::str(_out_buffer.attr("read")());
-        _out_buffer.attr("truncate")(0);
-        _out_buffer.attr("seek")(0);
+        std::string out_string;
+
+        _out_ring.drain(out_string);
         return out_string;
     }
     ~PyStdStreamsRedirect() {
@@ -0,0 +1,96 @@
+#include "q_table.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+QTable::QTable(const string &path, uint32_t num_levels, uint32_t state_size,
+ uint32_t num_actions, uint64_t max_states)
+{
+    uint64_t num_states = 1;
+    struct stat st;
+    bool created = true;
+    void *addr;
+    int fd;
+
+    for (uint32_t i = 0; i < state_size; i ++){
+        num_states *= num_levels;
+        if (num_states > max_states)
+            throw cRuntimeError("Q-table would have more than %llu states, "
+             "reduce the number of queues or raise max_states",
+             (unsigned long long) max_states);
+    }
+    mapped_size = sizeof(QTableHeader) + num_states * num_actions * sizeof(float);
+
+    if (path.empty()){
+        addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            throw cRuntimeError("Cannot open Q-table %s: %s", path.c_str(), strerror(errno));
+        if (fstat(fd, &st) == 0 && st.st_size > 0){
+            created = false;
+            if ((size_t) st.st_size != mapped_size){
+                close(fd);
+                throw cRuntimeError("Q-table %s has a different shape", path.c_str());
+            }
+        } else if (ftruncate(fd, mapped_size) < 0){
+            close(fd);
+            throw cRuntimeError("Cannot resize Q-table %s: %s", path.c_str(), strerror(errno));
+        }
+        addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (addr == MAP_FAILED)
+        throw cRuntimeError("Cannot map Q-table: %s", strerror(errno));
+
+    header = (QTableHeader *) addr;
+    values = (float *) (header + 1);
+
+    if (created){
+        // values of new tables are zero, as the file is zero filled
+        header->magic = Q_TABLE_MAGIC;
+        header->version = Q_TABLE_VERSION;
+        header->num_levels = num_levels;
+        header->state_size = state_size;
+        header->num_actions = num_actions;
+        header->num_states = num_states;
+        header->num_updates = 0;
+    } else if (header->magic != Q_TABLE_MAGIC || header->version != Q_TABLE_VERSION
+     || header->num_levels != num_levels || header->state_size != state_size
+     || header->num_actions != num_actions){
+        munmap(addr, mapped_size);
+        throw cRuntimeError("Q-table %s has a different shape", path.c_str());
+    }
+}
+
+int QTable::best_action(uint64_t state)
+{
+    float *q = row(state);
+    int best = 0;
+
+    for (uint32_t a = 1; a < header->num_actions; a ++){
+        if (q[a] > q[best])
+            best = a;
+    }
+    return best;
+}
+
+void QTable::update(uint64_t state, int action, double reward, uint64_t next_state,
+ double learning_rate, double discount)
+{
+    float *q = row(state);
+    double target = reward + discount * row(next_state)[best_action(next_state)];
+
+    q[action] += learning_rate * (target - q[action]);
+    header->num_updates++;
+}
+
+QTable::~QTable()
+{
+    if (header != nullptr)
+        munmap((void *) header, mapped_size);
+}
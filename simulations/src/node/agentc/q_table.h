@@ -0,0 +1,94 @@
+#ifndef Q_TABLE_H
+#define Q_TABLE_H
+
+#include <omnetpp.h>
+#include <cstdint>
+#include <string>
+
+using namespace omnetpp;
+using namespace std;
+
+#define Q_TABLE_MAGIC 0x5154424c
+#define Q_TABLE_VERSION 1
+
+struct QTableHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_levels;
+  uint32_t state_size;
+  uint32_t num_actions;
+  uint32_t reserved;
+  uint64_t num_states;
+  // number of updates applied to the table over all the runs
+  uint64_t num_updates;
+};
+
+/**
+ * Table of action values of a tabular Q-learning agent.
+ *
+ * States are vectors of state_size quantized features, each one taking
+ * num_levels values, and are indexed in mixed radix.
+ * The table is memory mapped from a file, so that it survives the simulation
+ * and the next runs can start from the learned values. With no file, the
+ * table lives in anonymous memory.
+*/
+class QTable {
+
+  protected:
+    QTableHeader *header = nullptr;
+    float *values = nullptr;
+    size_t mapped_size = 0;
+
+  public:
+    /**
+     * Maps the table file at path, creating it if it does not exist.
+     * An existing file must have been created with the same shape.
+     * An empty path means no persistence.
+    */
+    QTable(const string &path, uint32_t num_levels, uint32_t state_size, uint32_t num_actions,
+     uint64_t max_states);
+    ~QTable();
+
+    uint64_t getNumStates() const {
+      return header->num_states;
+    }
+
+    uint32_t getNumActions() const {
+      return header->num_actions;
+    }
+
+    uint64_t getNumUpdates() const {
+      return header->num_updates;
+    }
+
+    /**
+     * Returns the index of the state with the given quantized features.
+    */
+    uint64_t state_index(const uint32_t *levels) const {
+      uint64_t index = 0;
+
+      for (uint32_t i = 0; i < header->state_size; i ++){
+        index = index * header->num_levels + levels[i];
+      }
+      return index;
+    }
+
+    float *row(uint64_t state) {
+      return values + state * header->num_actions;
+    }
+
+    /**
+     * Returns the action with the max value in the state, the first one
+     * on ties.
+    */
+    int best_action(uint64_t state);
+
+    /**
+     * Applies the Q-learning update of the value of action in state, given the
+     * reward and the state reached.
+    */
+    void update(uint64_t state, int action, double reward, uint64_t next_state,
+     double learning_rate, double discount);
+};
+
+#endif // Q_TABLE_H
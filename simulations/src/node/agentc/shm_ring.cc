@@ -0,0 +1,132 @@
+#include "shm_ring.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static ShmAgentSegment *shm_agent_map(const char *name, int flags, std::string &error)
+{
+    int fd;
+    void *addr;
+
+    fd = shm_open(name, flags, 0600);
+    if (fd < 0){
+        error = std::string("shm_open ") + name + ": " + strerror(errno);
+        return nullptr;
+    }
+    if ((flags & O_CREAT) && ftruncate(fd, sizeof(ShmAgentSegment)) < 0){
+        error = std::string("ftruncate ") + name + ": " + strerror(errno);
+        close(fd);
+        return nullptr;
+    }
+
+    addr = mmap(nullptr, sizeof(ShmAgentSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping keeps the segment alive
+    close(fd);
+    if (addr == MAP_FAILED){
+        error = std::string("mmap ") + name + ": " + strerror(errno);
+        return nullptr;
+    }
+
+    return (ShmAgentSegment *) addr;
+}
+
+ShmAgentSegment *shm_agent_create(const char *name, std::string &error)
+{
+    ShmAgentSegment *segment;
+
+    shm_agent_unlink(name);
+    segment = shm_agent_map(name, O_RDWR | O_CREAT | O_EXCL, error);
+    if (segment == nullptr)
+        return nullptr;
+
+    memset((void *) segment, 0, sizeof(ShmAgentSegment));
+    segment->version = SHM_AGENT_VERSION;
+    segment->num_channels = SHM_AGENT_MAX_CHANNELS;
+    for (ShmAgentChannel &channel : segment->channels){
+        channel.state.store(SHM_CHANNEL_FREE, std::memory_order_relaxed);
+        channel.generation.store(0, std::memory_order_relaxed);
+        channel.requests.init();
+        channel.responses.init();
+    }
+    // clients check the magic number before anything else, so it's written last
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = SHM_AGENT_MAGIC;
+
+    return segment;
+}
+
+ShmAgentSegment *shm_agent_open(const char *name, std::string &error)
+{
+    ShmAgentSegment *segment;
+    struct stat st;
+    int fd;
+
+    // a segment smaller than expected was created by someone else
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd >= 0){
+        if (fstat(fd, &st) == 0 && (size_t) st.st_size < sizeof(ShmAgentSegment)){
+            close(fd);
+            error = std::string(name) + " is not an agent server segment";
+            return nullptr;
+        }
+        close(fd);
+    }
+
+    segment = shm_agent_map(name, O_RDWR, error);
+    if (segment == nullptr)
+        return nullptr;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment->magic != SHM_AGENT_MAGIC || segment->version != SHM_AGENT_VERSION){
+        error = std::string(name) + " is not an agent server segment of version "
+         + std::to_string(SHM_AGENT_VERSION);
+        shm_agent_close(segment);
+        return nullptr;
+    }
+
+    return segment;
+}
+
+void shm_agent_close(ShmAgentSegment *segment)
+{
+    munmap((void *) segment, sizeof(ShmAgentSegment));
+}
+
+void shm_agent_unlink(const char *name)
+{
+    shm_unlink(name);
+}
+
+int shm_agent_claim_channel(ShmAgentSegment *segment, uint32_t num_queues,
+ const char *implementation)
+{
+    for (uint32_t i = 0; i < segment->num_channels; i ++){
+        ShmAgentChannel &channel = segment->channels[i];
+        uint32_t expected = SHM_CHANNEL_FREE;
+
+        if (!channel.state.compare_exchange_strong(expected, SHM_CHANNEL_CLAIMED,
+         std::memory_order_acquire))
+            continue;
+
+        // rings are left empty by the previous owner, but a crashed client
+        // may have left records behind
+        channel.requests.init();
+        channel.responses.init();
+        channel.num_queues = num_queues;
+        strncpy(channel.implementation, implementation, SHM_AGENT_IMPLEMENTATION_LEN - 1);
+        channel.implementation[SHM_AGENT_IMPLEMENTATION_LEN - 1] = '\0';
+        channel.generation.fetch_add(1, std::memory_order_relaxed);
+        channel.state.store(SHM_CHANNEL_ACTIVE, std::memory_order_release);
+        return i;
+    }
+
+    return -1;
+}
+
+void shm_agent_release_channel(ShmAgentSegment *segment, int channel)
+{
+    segment->channels[channel].state.store(SHM_CHANNEL_FREE, std::memory_order_release);
+}
@@ -0,0 +1,169 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Shared memory transport between agent clients and a local agent server.
+ *
+ * The server creates a segment made of a fixed number of channels. Each agent
+ * client (i.e. each node of each simulation run) claims a free channel and then
+ * exchanges records with the server through two single producer single consumer
+ * rings: requests go from the client to the server, responses come back.
+ * Rings are lock-free, the only synchronization is the release/acquire pair on
+ * the head and tail counters.
+ *
+ * The layout is shared with agent/shm_server.py: keep them in sync.
+*/
+
+#define SHM_AGENT_MAGIC 0x434c4147
+#define SHM_AGENT_VERSION 1
+#define SHM_AGENT_DEFAULT_NAME "/cl_agent"
+#define SHM_AGENT_MAX_CHANNELS 32
+#define SHM_AGENT_MAX_QUEUES 64
+// must be a power of 2
+#define SHM_AGENT_RING_SIZE 8
+#define SHM_AGENT_IMPLEMENTATION_LEN 240
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+ "shared memory rings need address-free 64 bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+ "shared memory rings need address-free 32 bit atomics");
+
+/**
+ * Same content of an ActionRequest: the state of the node and the reward for
+ * the last action.
+*/
+struct ShmActionRequest {
+  uint64_t seq;
+  float reward;
+  float energy;
+  float charge_rate;
+  uint32_t num_queues;
+  float queue_occ[SHM_AGENT_MAX_QUEUES];
+};
+
+/**
+ * Same content of an ActionResponse. seq is the one of the corresponding request.
+*/
+struct ShmActionResponse {
+  uint64_t seq;
+  int32_t send_message;
+  int32_t power_source;
+  int32_t queue;
+  int32_t msg_to_send;
+};
+
+/**
+ * Single producer single consumer ring of records.
+ *
+ * head is written only by the consumer, tail only by the producer, and they
+ * live in different cache lines.
+*/
+template <class T, size_t N>
+struct ShmSpscRing {
+  static_assert((N & (N - 1)) == 0, "ring size must be a power of 2");
+
+  std::atomic<uint64_t> head;
+  char head_pad[56];
+  std::atomic<uint64_t> tail;
+  char tail_pad[56];
+  T records[N];
+
+  void init() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+  bool push(const T &record) {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+
+    if (t - head.load(std::memory_order_acquire) == N)
+      return false;
+    records[t & (N - 1)] = record;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &record) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+
+    if (h == tail.load(std::memory_order_acquire))
+      return false;
+    record = records[h & (N - 1)];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+  }
+};
+
+enum ShmChannelState : uint32_t {
+  SHM_CHANNEL_FREE = 0,
+  // claimed by a client which is still writing the channel params
+  SHM_CHANNEL_CLAIMED = 1,
+  // served by the server
+  SHM_CHANNEL_ACTIVE = 2
+};
+
+struct ShmAgentChannel {
+  std::atomic<uint32_t> state;
+  // incremented at every claim, so that the server knows when it must build
+  // a new agent for the channel
+  std::atomic<uint32_t> generation;
+  uint32_t num_queues;
+  uint32_t reserved;
+  char implementation[SHM_AGENT_IMPLEMENTATION_LEN];
+  ShmSpscRing<ShmActionRequest, SHM_AGENT_RING_SIZE> requests;
+  ShmSpscRing<ShmActionResponse, SHM_AGENT_RING_SIZE> responses;
+};
+
+struct ShmAgentSegment {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t num_channels;
+  uint32_t reserved[13];
+  ShmAgentChannel channels[SHM_AGENT_MAX_CHANNELS];
+};
+
+// checks the layout assumed by agent/shm_server.py
+static_assert(sizeof(ShmActionRequest) == 280, "unexpected request layout");
+static_assert(sizeof(ShmActionResponse) == 24, "unexpected response layout");
+static_assert(offsetof(ShmAgentChannel, requests) == 256, "unexpected channel layout");
+static_assert(sizeof(ShmAgentChannel) == 2944, "unexpected channel layout");
+static_assert(offsetof(ShmAgentSegment, channels) == 64, "unexpected segment layout");
+
+/**
+ * Creates the segment with the given name, replacing any stale one.
+ * Returns nullptr and writes the reason to error on failure.
+*/
+ShmAgentSegment *shm_agent_create(const char *name, std::string &error);
+
+/**
+ * Opens the segment created by a running server.
+ * Returns nullptr and writes the reason to error on failure.
+*/
+ShmAgentSegment *shm_agent_open(const char *name, std::string &error);
+
+void shm_agent_close(ShmAgentSegment *segment);
+
+/**
+ * Removes the segment name, mapped segments stay valid until closed.
+*/
+void shm_agent_unlink(const char *name);
+
+/**
+ * Claims a free channel of the segment and activates it.
+ * Returns the channel index, or -1 if all the channels are in use.
+*/
+int shm_agent_claim_channel(ShmAgentSegment *segment, uint32_t num_queues,
+ const char *implementation);
+
+void shm_agent_release_channel(ShmAgentSegment *segment, int channel);
+
+#endif // SHM_RING_H
@@ -20,23 +20,32 @@
 #include "power/battery.h"
 #include "power/power_chord.h"
 #include "power/random_charger.h"
+#include "power/lazy_battery.h"
+#include "power/trace_charger.h"
 #include "QueueDataRequest_m.h"
 #include <cstddef>
+#include <cstring>
 #include "statistics.h"
+#include "message_pool.h"
 
 Define_Module(Controller);
 
 //Node behaviour when started
 void Controller::initialize()
 {
+    init_quantity_signals();
     init_module_params();
     init_timers();
     init_power_sources();
     init_queue_states();
     init_reward_params();
+
+    energy_ledger = new EnergyLedger(this, getParentModule(), EWMA_ALPHA_DEFAULT);
     
     start_timer(ask_action_timeout);
-    start_timer(charge_battery_timeout);
+    // a lazy battery charges itself
+    if (!lazy_battery_charge)
+        start_timer(charge_battery_timeout);
 
 }
 
@@ -68,13 +77,12 @@ void Controller::ask_action(){
 
 void Controller::update_queue_state(QueueStateUpdate *msg, size_t queue_idx)
 {
-    queue_states[queue_idx].occupancy = msg->getBuffer_pop_percentage();
-    queue_states[queue_idx].pkt_drop_cnt += msg->getNum_of_dropped();
-    queue_states[queue_idx].pkt_inbound_cnt += msg->getNum_of_inbound();
-    set_if_greater(queue_states[queue_idx].max_pkt_drop_cnt, queue_states[queue_idx].pkt_drop_cnt);
+    queue_states.update(queue_idx, msg->getBuffer_pop_percentage(),
+     msg->getNum_of_dropped(), msg->getNum_of_inbound());
+    reward_engine->mark_queue_dirty(queue_idx);
     EV_DEBUG << "Queue " << queue_idx << " state updated with occupancy: " 
-    << queue_states[queue_idx].occupancy << "%" << " and pkt dropped: " 
-    << queue_states[queue_idx].pkt_drop_cnt << endl;
+    << queue_states.occupancy[queue_idx] << "%" << " and pkt dropped: " 
+    << queue_states.pkt_drop_cnt[queue_idx] << endl;
 }
 
 void Controller::charge_battery()
@@ -99,11 +107,11 @@ inline void Controller::measure_action(bool must_send, unsigned int queue, unsig
     unsigned int action;
 
     if(!must_send) 
-        measure_quantity("do_nothing", 1);
+        measure_declared_quantity(do_nothing, 1);
     else if (power_source == SelectPowerSource::BATTERY)
-        measure_quantity("send_battery", 1);
+        measure_declared_quantity(send_battery, 1);
     else if (power_source == SelectPowerSource::POWER_CHORD)
-        measure_quantity("send_powerchord", 1);
+        measure_declared_quantity(send_powerchord, 1);
 
     if (must_send)
     {
@@ -114,7 +122,7 @@ inline void Controller::measure_action(bool must_send, unsigned int queue, unsig
         action = 0;
     }
         
-    measure_quantity("action", action);
+    measure_declared_quantity(action, action);
 }
 
 /*
@@ -138,8 +146,9 @@ void Controller::do_action(ActionResponse *action)
     else{
         EV_DEBUG << "Received action " << action_type << "->Send data" << endl;
         EV_DEBUG << "Asking data to queue " << queue << " for " << num_msg_to_send << " messages" << endl;
+        measure_declared_quantity(batch_size, num_msg_to_send);
         //Pop packet from queue
-        QueueDataRequest *queueDataRequest = new QueueDataRequest();
+        QueueDataRequest *queueDataRequest = acquire_msg<QueueDataRequest>();
         queueDataRequest->setData_n(num_msg_to_send);
         send(queueDataRequest, "queue_ports$o", queue); 
     }
@@ -175,11 +184,11 @@ void Controller::forward_data(const DataMsg *data[], size_t num_data){
         for (int i = 0; i < num_data; i++){
             data_bits = data[i]->getData() * 8;
             service_interval = data_bits * 1e-6 / link_cap;
-            measure_quantity("service_interval", service_interval);
-            measure_quantity("response_time", simTime() - data[i]->getQueueing_time() + service_interval);
+            measure_declared_quantity(service_interval, service_interval);
+            measure_declared_quantity(response_time, simTime() - data[i]->getQueueing_time() + service_interval);
         }
         if (service_interval > 0)
-            measure_quantity("service_interval", service_interval);
+            measure_declared_quantity(service_interval, service_interval);
         
         
         last_reward=compute_reward();
@@ -198,12 +207,15 @@ void Controller::_forward_data(const DataMsg *data[], size_t num_data)
     last_energy_consumed[SelectPowerSource::BATTERY]=0;
     mWh_t tot_consumed=0;
     mWh_t battery_level;
+    b_t burst_bits = 0;
 
+    // the whole batch is sent in a single burst, so its energy is computed
+    // once for all the bits
     for(int i=0; i<num_data; i++){
         EV_DEBUG << "Data " << i << " size: " << (int) data[i]->getData() << std::endl;
-        tot_consumed
-            += (60 * 60 * power_model-> calc_tx_consumption_mWs((int) data[i]->getData()*8, link_cap)); // *8 for bits, converted in mWh
+        burst_bits += (int) data[i]->getData()*8; // *8 for bits
     }      
+    tot_consumed = 60 * 60 * power_model->calc_tx_consumption_mWs(burst_bits, link_cap); // converted in mWh
     
     //Consume energy
     switch(last_select_power_source){
@@ -242,123 +254,25 @@ reward_t Controller::compute_reward(){
 
     EV_DEBUG << "Computing reward" << endl;
 
-    reward_t reward = 0;
-    vector<RewardTerm *> reward_terms;
-
-    double energy_penalty_norm_factor; 
-    double pkt_drop_penalty_norm_factor;
-    double queue_occ_penalty_norm_factor;
+    reward_t reward;
 
-    /**
-     * To normalize the reward terms, we need to know the maximum value
-     * for each term. To compute it, we must leverage the same signal used by the
-     * corresponding reward term. So we need to use a temporary reward term with
-     * a signal value corresponding to the maximum possible value of it.
-    */
-
-    // includes energy term
     for(int i=0; i<power_sources.size(); i++)
     {
         set_if_greater(max_energy_consumed[i], last_energy_consumed[i]);
-        energy_penalty_norm_factor
-            = RewardTerm(reward_term_models, "energy_penalty").bind_symbols(
-            {
-                {"energy_consumed", cValue(max_energy_consumed[i])},
-                {"cost_per_mWh", cValue(sum_power_sources_costs)}
-            })->setWeight(1)->compute();
-        include_reward_term("energy_penalty",
-         {
-            {"energy_consumed", cValue(last_energy_consumed[i])},
-            {"cost_per_mWh", (power_sources[i]->getCostPerMWh())}
-         },
-         reward_terms,
-         new MinMaxNormalizer(0, absolute(energy_penalty_norm_factor)));
-    EV_DEBUG << "Energy term for power source " << i << "included" << endl;
-    EV_DEBUG << "energy_penalty_norm_factor for power source " << i << ": " << energy_penalty_norm_factor << endl;
-    }
-    
-    // includes queue occ penalties, one term for each priority
-    for (int queue = 0; queue < num_queues; queue ++)
-    {
-        queue_occ_penalty_norm_factor
-         = RewardTerm(reward_term_models, "queue_occ_penalty").bind_symbols(
-         {
-            {"priority", cValue(sum_priorities)},
-            {"queue_occ", cValue(100)}, //100 cause it's the max value, used for normalization
-         })->setWeight(1)->compute();
-        include_reward_term("queue_occ_penalty",
-         {
-            {"priority", cValue(queue + 1)},
-            {"queue_occ", cValue(queue_states[queue].occupancy)}
-         },
-         reward_terms,
-         new MinMaxNormalizer(0, absolute(queue_occ_penalty_norm_factor)));
-        
-        EV_DEBUG << "Queue occ term for priority "
-         << queue << "included" << endl;
-        EV_DEBUG << "max queue occ penalty for priority " << queue << ": "
-         << queue_occ_penalty_norm_factor << endl;
     }
 
-    // includes pkt drop penalties, one term for each priority
-    for (int queue = 0; queue < num_queues; queue ++)
-    {
-        EV_DEBUG << "pkt drop count for priority " << queue << ": "
-         << queue_states[queue].pkt_drop_cnt << endl;
-                
-        pkt_drop_penalty_norm_factor
-         = RewardTerm(reward_term_models, "pkt_drop_penalty").bind_symbols(
-         {
-            {"priority", cValue(sum_priorities)},
-            {"pkt_drop_count", cValue(queue_states[queue].pkt_inbound_cnt)}
-         })->setWeight(1)->compute();
-        include_reward_term("pkt_drop_penalty",
-         {
-            {"priority", cValue(queue + 1)},
-            {"pkt_drop_count", cValue(queue_states[queue].pkt_drop_cnt)}
-         },
-         reward_terms,
-         new MinMaxNormalizer(0, absolute(pkt_drop_penalty_norm_factor)));
-        // resets pkt counts after reading them
-        queue_states[queue].reset_counts();
-
-        EV_DEBUG << "Pkt drop term for priority " 
-         << queue << "included: " << endl;
-        EV_DEBUG << "max pkt drop penalty for priority " << queue << ": "
-         << pkt_drop_penalty_norm_factor << endl;
-    }
+    // queues writing their state in place cannot notify the reward engine
+    queue_states.take_changed([this](int queue) {
+        reward_engine->mark_queue_dirty(queue);
+    });
 
-    // computes reward by consuming and reducing all included reward terms
-    for (RewardTerm *reward_term : reward_terms)
-    {
-        EV_DEBUG << "reward term: " << reward_term->compute() << endl;
-        reward = reward + reward_term->compute();
-        EV_DEBUG << "partial reward: " << reward << endl;
-        delete reward_term;
-    }
+    reward = reward_engine->compute(last_energy_consumed, max_energy_consumed, queue_states);
 
     if (reward < -1) EV_WARN << "reward is < -1" << endl;
     
     return reward;
 }
 
-void Controller::include_reward_term(const char* reward_term_model_name,
- map<string, cValue> symbols, vector<RewardTerm *> &reward_terms)
-{
-    RewardTerm *reward_term;
-    
-    reward_term = new RewardTerm(reward_term_models, reward_term_model_name);
-    reward_term->bind_symbols(symbols);
-    reward_terms.push_back(reward_term);
-}
-
-void Controller::include_reward_term(const char *reward_term_model_name,
- map<string, cValue> symbols, vector<RewardTerm *> &reward_terms, Normalizer *normalizer)
-{
-    include_reward_term(reward_term_model_name, symbols, reward_terms);
-    reward_terms.back()->setNormalizer(normalizer);
-}
-
 void Controller::start_timer(Timeout *timeout)
 {
     EV_DEBUG << "Starting timer at " << simTime() << endl;
@@ -389,13 +303,16 @@ void Controller::sample_power_sources(NodeStateMsg &state_msg)
     state_msg.setEnergy_percentage(battery_level);
 
     // samples last measured battery charge rate
+    if (lazy_battery != nullptr)
+        last_charge_rate = calc_percentage(lazy_battery->getLastChargeAmount(),
+         lazy_battery->getCapacity());
     state_msg.setCharge_rate_percentage(last_charge_rate);
 }
 
 void Controller::sample_queue_states(NodeStateMsg &state_msg)
 {
-    for (struct QueueState &qstate : queue_states){
-        state_msg.appendQueue_pop_percentage(qstate.occupancy);
+    for (percentage_t occupancy : queue_states.occupancy){
+        state_msg.appendQueue_pop_percentage(occupancy);
     }
 }
 
@@ -423,13 +340,13 @@ void Controller::measure_quantities()
         energy_expense += last_energy_consumed[i] * power_sources[i]->getCostPerMWh();
         energy_potential_expense += last_energy_consumed[i] * most_expensive_power_source->getCostPerMWh();
     }
-    measure_quantity("energy_expense", energy_expense);
-    measure_quantity("energy_consumption", energy_consumption);
-    measure_quantity("energy_potential_expense", energy_potential_expense);
+    measure_declared_quantity(energy_expense, energy_expense);
+    measure_declared_quantity(energy_consumption, energy_consumption);
+    measure_declared_quantity(energy_potential_expense, energy_potential_expense);
     
-    measure_quantity("battery_charge_level",
+    measure_declared_quantity(battery_charge_level,
      power_sources[SelectPowerSource::BATTERY]->getCharge());
-    measure_quantity("reward", last_reward);
+    measure_declared_quantity(reward, last_reward);
 
 }
 
@@ -447,6 +364,7 @@ void Controller::init_reward_params()
 {
     // reward params are now written in the reward_term_models cValueMap.
     // here are inited only the params not listed in the reward_term_models.
+    vector<reward_t> power_sources_costs;
 
     sum_priorities = ((num_queues * (num_queues + 1))/2);
     EV_DEBUG << "sum_priorities: " << sum_priorities << endl;
@@ -457,6 +375,24 @@ void Controller::init_reward_params()
         }
         return sum;
     }();
+
+    // builds all the reward terms once, they are reused at every step
+    for (PowerSource *ps : power_sources){
+        power_sources_costs.push_back(ps->getCostPerMWh());
+    }
+    reward_engine = new RewardEngine(reward_term_models, num_queues, power_sources_costs);
+    reward_engine->setIncremental(incremental_reward);
+    if (compile_reward_signals)
+        reward_engine->setCompiledSignals(true);
+    if (strcmp(reward_kernel, "simd") == 0){
+        if (incremental_reward)
+            throw cRuntimeError("reward_kernel \"simd\" cannot be combined with incremental_reward");
+        if (!reward_engine->setKernel(true))
+            EV_WARN << "queue term signals are not linear in priority * quantity, "
+             << "falling back to \"expr\" reward kernel" << endl;
+    } else if (strcmp(reward_kernel, "expr") != 0){
+        throw cRuntimeError("Unknown reward_kernel %s", reward_kernel);
+    }
 }
 
 
@@ -476,6 +412,15 @@ void Controller::init_module_params()
     charge_battery_timeout_delta 
      = par("charge_battery_timeout_delta").doubleValue();
     reward_term_models = (cValueMap *) par("reward_term_models").objectValue()->dup();
+    incremental_reward = par("incremental_reward").boolValue();
+    reward_kernel = par("reward_kernel").stringValue();
+    compile_reward_signals = par("compile_reward_signals").boolValue();
+    shared_queue_state = par("shared_queue_state").boolValue();
+    lazy_battery_charge = par("lazy_battery_charge").boolValue();
+    battery_idle_drain = par("battery_idle_drain").boolValue();
+    battery_charger_type = par("battery_charger_type").stringValue();
+    solar_trace_file = par("solar_trace_file").stringValue();
+    solar_trace_loop = par("solar_trace_loop").boolValue();
     hybris = par("hybris").doubleValue();
     max_pkt_size = par("max_pkt_size").doubleValueInUnit("B");
     // add more module params here ...
@@ -485,6 +430,13 @@ void Controller::init_module_params()
     EV_DEBUG << "charge battery timeout delta: "<< charge_battery_timeout_delta << endl;
     EV_DEBUG << "ask action timeout delta: " << ask_action_timeout_delta << endl;
     EV_DEBUG << "hybris: " << hybris << endl;
+    EV_DEBUG << "incremental_reward: " << incremental_reward << endl;
+    EV_DEBUG << "reward_kernel: " << reward_kernel << endl;
+    EV_DEBUG << "compile_reward_signals: " << compile_reward_signals << endl;
+    EV_DEBUG << "shared_queue_state: " << shared_queue_state << endl;
+    EV_DEBUG << "lazy_battery_charge: " << lazy_battery_charge << endl;
+    EV_DEBUG << "battery_idle_drain: " << battery_idle_drain << endl;
+    EV_DEBUG << "battery_charger_type: " << battery_charger_type << endl;
     EV_DEBUG << "num_queues: " << num_queues << endl;
     EV_DEBUG << "max_neighbours: " << max_neighbours << endl;
     EV_DEBUG << "link_cap: " << link_cap << "bps" << endl;
@@ -501,9 +453,29 @@ void Controller::init_power_sources()
     cValueMap *battery_charger_params
      = (cValueMap *) power_source_models->get("solar_panel").objectValue();
         
-    
-    power_sources.insert(power_sources.begin() + SelectPowerSource::BATTERY,
-     new Battery(battery_params->get("cap_mWh").doubleValueInUnit("mWh")));
+    // init battery charger
+    if (strcmp(battery_charger_type, "random") == 0)
+        battery_charger = new RandomCharger(par("battery_charge_rate_distribution"),
+         battery_charger_params->get("cap_mWh").doubleValueInUnit("mWh"));
+    else if (strcmp(battery_charger_type, "trace") == 0)
+        battery_charger = new TraceCharger(solar_trace_file,
+         battery_charger_params->get("cap_mWh").doubleValueInUnit("mWh"),
+         solar_trace_loop);
+    else
+        throw cRuntimeError("Unknown battery charger type %s", battery_charger_type);
+    EV_DEBUG << "max charge is " << battery_charger->getCapacity() << endl;
+    battery_charger->plug();
+
+    if (lazy_battery_charge){
+        // the battery draws its charges from the charger by itself
+        lazy_battery = new LazyBattery(battery_params->get("cap_mWh").doubleValueInUnit("mWh"),
+         battery_charger, charge_battery_timeout_delta,
+         battery_idle_drain ? power_model->getIdle_mW() : 0);
+        power_sources.insert(power_sources.begin() + SelectPowerSource::BATTERY, lazy_battery);
+    }
+    else
+        power_sources.insert(power_sources.begin() + SelectPowerSource::BATTERY,
+         new Battery(battery_params->get("cap_mWh").doubleValueInUnit("mWh")));
     power_sources[SelectPowerSource::BATTERY]
      ->setCostPerMWh(battery_params->get("cost_per_mWh").doubleValue());
     power_sources[SelectPowerSource::BATTERY]->plug();
@@ -521,13 +493,6 @@ void Controller::init_power_sources()
         last_energy_consumed.push_back(0);
     }
 
-    // init battery charger
-    cPar &charge_rate_distribution = par("battery_charge_rate_distribution");
-    battery_charger = new RandomCharger(par("battery_charge_rate_distribution"),
-     battery_charger_params->get("cap_mWh").doubleValueInUnit("mWh"));
-    EV_DEBUG << "max charge is " << battery_charger->getCapacity() << endl;
-    battery_charger->plug();
-
     // inits max energy consumed    
     max_energy_consumed.resize(power_sources.size(), max_packet_size * 8 * power_model->getTx_mW());
 
@@ -542,7 +507,7 @@ void Controller::init_power_sources()
 
 void Controller::init_queue_states()
 {
-    queue_states.resize(num_queues, (struct QueueState){0});  
+    queue_states.resize(num_queues);
 }
 
 void Controller::handleActionResponse(ActionResponse *msg)
@@ -584,7 +549,9 @@ void Controller::handleQueueDataResponse(QueueDataResponse *msg)
     size_t queue_idx; 
     queue_idx = msg->getArrivalGate()->getIndex();
     const QueueStateUpdate *stateUpdate=msg->getStateUpdate();
-    update_queue_state(const_cast<QueueStateUpdate *>(stateUpdate), queue_idx);
+    // queues sharing their state do not piggyback updates
+    if (stateUpdate != nullptr)
+        update_queue_state(const_cast<QueueStateUpdate *>(stateUpdate), queue_idx);
     
     //Retrieve and forward data
     const DataMsg *data[num_data_recv];
@@ -659,10 +626,12 @@ void Controller::handleMessage(cMessage *msg)
         {
         case (int) QueueMsgKind::QUEUE_DATA_RESPONSE:
             handleQueueDataResponse((QueueDataResponse *)msg);
-            break;
+            release_msg((QueueDataResponse *)msg);
+            goto handleMessage_do_not_delete_msg;
         case (int) QueueMsgKind::QUEUE_STATE_UPDATE:
             handleQueueStateUpdate((QueueStateUpdate *)msg);
-            break;
+            release_msg((QueueStateUpdate *)msg);
+            goto handleMessage_do_not_delete_msg;
         default:
             break;
         }
@@ -679,6 +648,12 @@ handleMessage_do_not_delete_msg:
 
 }
 
+void Controller::finish()
+{
+    record_message_pool_stats(this);
+    energy_ledger->record_scalars();
+}
+
 Controller::~Controller()
 {
     cancelAndDelete(ask_action_timeout);
@@ -687,5 +662,8 @@ Controller::~Controller()
     delete power_model;
     delete power_models;
     delete power_source_models;
+    delete reward_engine;
     delete reward_term_models;
+    delete energy_ledger;
+    delete battery_charger;
 }
@@ -27,158 +27,32 @@
 #include <vector>
 #include "QueueDataResponse_m.h"
 #include "units.h"
+#include "queue_state.h"
+#include "reward/reward_engine.h"
+#include "statistics.h"
+#include "stats/energy_ledger.h"
+#include "power/lazy_battery.h"
 
 using namespace omnetpp;
 using namespace std;
 
-#define set_if_greater(_actual, _candidate) if (_candidate > _actual) _actual = _candidate  
-
-struct QueueState {
-  percentage_t occupancy;
-  int pkt_drop_cnt;
-  int pkt_inbound_cnt;
-  int max_pkt_drop_cnt;
-
-  void reset_counts(){
-    pkt_drop_cnt = 0;
-    pkt_inbound_cnt = 0;
-  }
-};
-
-/**
- * Normalizer is an abstract class that defines a method to normalize a value.
- * 
- * Normalization is the process of scaling and centering variables.
- * This can be useful when the variables have different units or scales.
- * 
- * For example, if we have two variables, one in the range [0, 100] and the other
- * in the range [0, 1000], the second variable will have a greater impact on the
- * computation of the reward.
- * 
- * Normalization can be used to scale the variables to the same range, so that
- * they have the same impact on the computation of the reward.
-*/
-class Normalizer {
-
-  public:
-    virtual double normalize(double value) { return value; };
-};
-
-/**
- * Restricts values from range [min, max] to [a, b]
- * https://en.m.wikipedia.org/wiki/Feature_scaling#Rescaling_(min-max_normalization)
- * 
- * For example, if we want to transform values in percentages:
- * 
- * Normalizer *normalizer = new MinMaxNormalizer(0, max, 0, 1);
- * double percentage = normalizer->normalize(value) * 100;
-*/
-class MinMaxNormalizer : public Normalizer {
-
-  private:
-    double min;
-    double max;
-    double a;
-    double b;
-
-  public:
-    MinMaxNormalizer(double min, double max) : MinMaxNormalizer(min, max, -1, 0) {}
-    MinMaxNormalizer(double min, double max, double a, double b)
-     : min(min), max(max), a(a), b(b) {}
-
-    double normalize(double value) override {
-      if (max == min) return 0;
-      return ((value - min) * (b - a)) / (max - min);
-    }
-};
-
-/**
- * Reward can be computed as a combination of different terms.
- * Each term comes with a signal along with its weight.
- * 
- * The signal is a function of a measured quantity which is informative about the
- * agent perfomance (e.g. energy consumption, queue occupancy, etc.).
- * 
- * The weight is a scalar that determines the importance of the corresponding term in
- * the reward computation.
- * 
- * Since signals are dynamic expressions (specified in .ini file), their symbols must
- * be bound to actual values at runtime before computing the term value.
-*/
-class RewardTerm {
-  
-protected:
-  reward_t weight;
-  cOwnedDynamicExpression *signal;
-  Normalizer *normalizer;
-
-  bool cached = false;
-  reward_t cached_value;
-
-public:
-  RewardTerm(reward_t weight, cOwnedDynamicExpression *signal)
-   : weight(weight), signal(signal->dup()) {
-    normalizer = new Normalizer();
-   }
-  RewardTerm(cValueMap *reward_term_map)
-   : RewardTerm(reward_term_map->get("weight").doubleValue(),
-    (cOwnedDynamicExpression *)reward_term_map->get("signal").objectValue()) {}
-  RewardTerm(cValueMap *reward_term_models, const char *reward_term_model_name)
-   : RewardTerm((cValueMap *) reward_term_models->get(reward_term_model_name)
-    .objectValue()) {}
-  
-  ~RewardTerm(){
-    delete signal;
-    delete normalizer;
-  }
-
-  reward_t getWeight() const {
-    return weight;
-  }
-
-  cOwnedDynamicExpression* getSignal() const {
-    return signal;
-  }
-
-  RewardTerm *setWeight(reward_t weight) {
-    this->weight = weight;
-    return this;
-  }
-
-  RewardTerm *setNormalizer(Normalizer *normalizer) {
-    delete this->normalizer;
-    this->normalizer = normalizer;
-    return this;
-  }
-  
-  RewardTerm *bind_symbols(map<string, cValue> symbols){
-    // resolver is owned by the dynamic expression, no need to delete it
-    // before setting a new one
-    signal->setResolver(new cDynamicExpression::SymbolTable(symbols));
-    return this;
-  }
-
-  reward_t compute(bool use_cache = true) {
-    
-    reward_t normalized_value;
-    
-    if (!use_cache || !cached){
-      if (signal->getResolver() == nullptr)
-        throw cRuntimeError("Signal resolver is not set. Call bind_symbols() first.");
-      
-      normalized_value = normalizer->normalize(signal->doubleValue());
-      cached_value = weight * normalized_value;
-    }  
-
-    return cached_value;
-  }
+#define CONTROLLER_QUANTITIES(X)\
+    X(do_nothing)\
+    X(send_battery)\
+    X(send_powerchord)\
+    X(action)\
+    X(batch_size)\
+    X(service_interval)\
+    X(response_time)\
+    X(energy_expense)\
+    X(energy_consumption)\
+    X(energy_potential_expense)\
+    X(battery_charge_level)\
+    X(reward)
 
-  void invalidate_cache(){
-    cached = false;
-  }
+#define set_if_greater(_actual, _candidate) if (_candidate > _actual) _actual = _candidate  
 
-};
-class Controller : public cSimpleModule
+class Controller : public cSimpleModule, public QueueStatesOwner
 {
   protected:
     reward_t last_reward; //Last reward computed
@@ -189,7 +63,7 @@ class Controller : public cSimpleModule
 
     vector<PowerSource *> power_sources;
     NICPowerModel *power_model;
-    PowerSource *battery_charger;
+    Charger *battery_charger = nullptr;
     PowerSource *most_expensive_power_source = nullptr;
        
     Timeout *ask_action_timeout;
@@ -202,10 +76,26 @@ class Controller : public cSimpleModule
      * The i-th element of this vector represents the up-to-date state
      * of the i-th queue.
     */
-    vector<QueueState> queue_states;
+    QueueStates queue_states;
 
     int sum_priorities;
     reward_t sum_power_sources_costs;
+
+    /**
+     * Reward terms are built once in init_reward_params() and reused
+     * at every reward computation.
+    */
+    RewardEngine *reward_engine = nullptr;
+
+    /**
+     * Signals of the quantities in CONTROLLER_QUANTITIES, resolved
+     * in initialize().
+    */
+    declare_quantities(CONTROLLER_QUANTITIES)
+
+    EnergyLedger *energy_ledger = nullptr;
+    // the battery, when it is charged lazily (see lazy_battery_charge)
+    LazyBattery *lazy_battery = nullptr;
     
     /**
      * Module parameters:
@@ -218,6 +108,15 @@ class Controller : public cSimpleModule
     cValueMap *power_models;
     cValueMap *power_source_models;
     cValueMap *reward_term_models;
+    bool incremental_reward;
+    const char *reward_kernel;
+    bool compile_reward_signals;
+    bool shared_queue_state;
+    bool lazy_battery_charge;
+    bool battery_idle_drain;
+    const char *battery_charger_type;
+    const char *solar_trace_file;
+    bool solar_trace_loop;
     reward_t hybris;
     B_t max_pkt_size;
 
@@ -279,6 +178,7 @@ class Controller : public cSimpleModule
 
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
 
     ~Controller();
 
@@ -296,23 +196,19 @@ class Controller : public cSimpleModule
     void handleQueueStateUpdate(QueueStateUpdate *msg);
     /**Specialized handlers (END)*/
 
-    //Util methods
-    reward_t compute_reward();
-    /**
-     * Creates a RewardTerm object from a reward term model and adds it to the
-     * user provided vector of reward terms.
-     * The symbols used in the RewardTerm signal are bound to the values provided
-     * in the symbols map.
-     * Values computed by the signal are normalized using the provided normalizer.
-    */
-    void include_reward_term(const char* reward_term_model_name,
-    map<string, cValue> symbols, vector<RewardTerm *> &reward_terms, 
-     Normalizer *normalizer);
+  public:
     /**
-     * Includes a term in the reward computation without normalization.
+     * Queues of the node write their state directly in queue_states
+     * if shared_queue_state is set.
     */
-    void include_reward_term(const char* reward_term_model_name,
-     map<string, cValue> symbols, vector<RewardTerm *> &reward_terms);
+    virtual QueueStates *getSharedQueueStates() override {
+      return shared_queue_state ? &queue_states : nullptr;
+    }
+
+  protected:
+
+    //Util methods
+    reward_t compute_reward();
     
     inline reward_t illegal_action_penalty()
     {
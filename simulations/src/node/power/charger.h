@@ -0,0 +1,29 @@
+#ifndef CHARGER_H
+#define CHARGER_H
+
+#include "power_source.h"
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/**
+ * A charger outputs energy to recharge other power sources, e.g. a solar
+ * panel. Its output may depend on time, so it can be read for a time other
+ * than the current one (see LazyBattery).
+*/
+class Charger : public PowerSource{
+public:
+    virtual ~Charger() {}
+
+    /**
+     * Returns the actual amount output at time t when the given amount
+     * is desired. Calls must be made in non decreasing order of t.
+    */
+    virtual mWh_t discharge_at(simtime_t_cref t, mWh_t amount) = 0;
+
+    mWh_t discharge(mWh_t amount) override {
+        return discharge_at(simTime(), amount);
+    }
+};
+
+#endif // CHARGER_H
@@ -0,0 +1,64 @@
+#include "lazy_battery.h"
+
+LazyBattery::LazyBattery(mWh_t capacity, Charger *charger, simtime_t charge_period,
+ mW_t idle_mW) : Battery(capacity)
+{
+    if (charge_period <= 0)
+        throw cRuntimeError("LazyBattery: charge period must be positive");
+
+    this->charger = charger;
+    this->charge_period = charge_period;
+    this->idle_mW = idle_mW;
+    last_update = simTime();
+    // the first charge comes one period after the start, as with a timer
+    next_charge_time = last_update + charge_period;
+}
+
+void LazyBattery::drain_idle(simtime_t_cref until)
+{
+    if (idle_mW > 0 && until > last_update){
+        // mWs to mWh
+        charge -= idle_mW * (until - last_update).dbl() / 3600;
+        if (charge < 0)
+            charge = 0;
+    }
+    last_update = until;
+}
+
+void LazyBattery::advance(simtime_t_cref now)
+{
+    // a charge due exactly now is applied before the caller's operation
+    while (next_charge_time <= now){
+        drain_idle(next_charge_time);
+        // tries to charge by the maximum amount the charger is able to output,
+        // the actual amount depends on the charger
+        last_charge_amount = charger->discharge_at(next_charge_time, charger->getCapacity());
+        Battery::recharge(last_charge_amount);
+        next_charge_time += charge_period;
+    }
+    drain_idle(now);
+}
+
+mWh_t LazyBattery::getCharge()
+{
+    advance(simTime());
+    return Battery::getCharge();
+}
+
+mWh_t LazyBattery::discharge(mWh_t amount)
+{
+    advance(simTime());
+    return Battery::discharge(amount);
+}
+
+void LazyBattery::recharge(mWh_t amount)
+{
+    advance(simTime());
+    Battery::recharge(amount);
+}
+
+mWh_t LazyBattery::getLastChargeAmount()
+{
+    advance(simTime());
+    return last_charge_amount;
+}
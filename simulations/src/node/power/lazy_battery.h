@@ -0,0 +1,56 @@
+#ifndef LAZY_BATTERY_H
+#define LAZY_BATTERY_H
+
+#include "battery.h"
+#include "charger.h"
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/**
+ * Battery recharged by a charger every charge_period, without events.
+ *
+ * The charge is a piecewise function of sim time: every time it is read or
+ * changed, the charges of the charger due since the last evaluation are
+ * applied in order, each one clamped to the capacity as a recharge() would
+ * do. Each charge is read from the charger for the time it is due, in the
+ * same order a periodic timer would read them, so the charging process is
+ * the same.
+ *
+ * If idle_mW is not 0, the battery is also drained by the idle consumption
+ * of the NIC between two evaluations.
+*/
+class LazyBattery : public Battery {
+protected:
+    Charger *charger;
+    simtime_t charge_period;
+    mW_t idle_mW;
+
+    // time the charge refers to
+    simtime_t last_update = 0;
+    // time of the next charge of the charger
+    simtime_t next_charge_time;
+    mWh_t last_charge_amount = 0;
+
+    void drain_idle(simtime_t_cref until);
+    /**
+     * Brings the charge to the given time.
+    */
+    void advance(simtime_t_cref now);
+
+public:
+    LazyBattery(mWh_t capacity, Charger *charger, simtime_t charge_period, mW_t idle_mW = 0);
+
+    mWh_t getCharge() override;
+
+    mWh_t discharge(mWh_t amount) override;
+
+    void recharge(mWh_t amount) override;
+
+    /**
+     * Returns the amount of the last charge of the charger.
+    */
+    mWh_t getLastChargeAmount();
+};
+
+#endif // LAZY_BATTERY_H
@@ -1,12 +1,12 @@
 #ifndef RANDOM_CHARGER_H_
 #define RANDOM_CHARGER_H_
 
-#include "power_source.h"
+#include "charger.h"
 #include <omnetpp.h>
 
 using namespace omnetpp;
 
-class RandomCharger : public PowerSource{
+class RandomCharger : public Charger{
 protected:
     cPar &distribution;
     mWh_t charge_cap;
@@ -19,9 +19,9 @@ public:
     /**
      * The user provided amount is interpreted as the desired amount of
      * energy. The actual amount is computed using the provided
-     * distribution.
+     * distribution, whatever the time is.
     */
-    mWh_t discharge(mWh_t amount) override {
+    mWh_t discharge_at(simtime_t_cref t, mWh_t amount) override {
         
         mWh_t actual_amount;
         double random;
@@ -47,4 +47,4 @@ public:
     }
 };
 
-#endif /* RANDOM_CHARGER_H_ */
\ No newline at end of file
+#endif /* RANDOM_CHARGER_H_ */
@@ -0,0 +1,33 @@
+#ifndef SOLAR_TRACE_H
+#define SOLAR_TRACE_H
+
+#include <cstdint>
+
+/**
+ * Format of the solar trace files read by TraceCharger.
+ *
+ * A trace file is a SolarTraceHeader followed by count SolarTraceSamples,
+ * in non decreasing order of time. All fields are little endian.
+ * The output of a sample is the fraction of the charger capacity output
+ * at that time, between 0 and 1.
+ *
+ * Trace files can be made from text files with tools/solar_trace_pack.
+ * It does not depend on OMNeT++, so standalone tools can write the traces.
+*/
+
+#define SOLAR_TRACE_MAGIC 0x544c4f53 // "SOLT"
+#define SOLAR_TRACE_VERSION 1
+
+struct SolarTraceHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+};
+
+struct SolarTraceSample {
+    // seconds
+    double time;
+    double output;
+};
+
+#endif // SOLAR_TRACE_H
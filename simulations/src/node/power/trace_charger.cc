@@ -0,0 +1,102 @@
+#include "trace_charger.h"
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TraceCharger::TraceCharger(const char *file_name, mWh_t charge_cap, bool loop)
+{
+    int fd;
+    struct stat st;
+    const SolarTraceHeader *header;
+
+    this->charge_cap = charge_cap;
+    this->loop = loop;
+    this->cost_per_mWh = 0;
+
+    fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        throw cRuntimeError("TraceCharger: cannot open solar trace %s", file_name);
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(SolarTraceHeader)){
+        close(fd);
+        throw cRuntimeError("TraceCharger: %s is not a solar trace", file_name);
+    }
+    mapping_size = st.st_size;
+    mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED){
+        mapping = nullptr;
+        throw cRuntimeError("TraceCharger: cannot map solar trace %s", file_name);
+    }
+
+    header = (const SolarTraceHeader *) mapping;
+    if (header->magic != SOLAR_TRACE_MAGIC || header->version != SOLAR_TRACE_VERSION
+     || header->count == 0
+     || header->count > (mapping_size - sizeof(SolarTraceHeader)) / sizeof(SolarTraceSample)){
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        throw cRuntimeError("TraceCharger: %s is not a solar trace or it is truncated", file_name);
+    }
+
+    samples = (const SolarTraceSample *) (header + 1);
+    count = header->count;
+}
+
+TraceCharger::~TraceCharger()
+{
+    if (mapping != nullptr)
+        munmap(mapping, mapping_size);
+}
+
+double TraceCharger::output_at(double t)
+{
+    double first_time = samples[0].time;
+    double span = samples[count - 1].time - first_time;
+    const SolarTraceSample *prev;
+    const SolarTraceSample *next;
+
+    if (loop && span > 0 && t > first_time)
+        t = first_time + fmod(t - first_time, span);
+
+    if (t <= first_time)
+        return samples[0].output;
+    if (t >= samples[count - 1].time)
+        return samples[count - 1].output;
+
+    // times are read in order, so the cursor moves forward by few samples,
+    // unless the trace looped
+    if (t < samples[cursor].time)
+        cursor = upper_bound(samples, samples + count, t,
+         [](double t, const SolarTraceSample &s){ return t < s.time; }) - samples - 1;
+    while (samples[cursor + 1].time <= t)
+        cursor ++;
+
+    prev = &samples[cursor];
+    next = &samples[cursor + 1];
+    return prev->output + (next->output - prev->output)
+     * (t - prev->time) / (next->time - prev->time);
+}
+
+mWh_t TraceCharger::discharge_at(simtime_t_cref t, mWh_t amount)
+{
+    double output;
+
+    abort_if_unplugged(0);
+
+    output = output_at(t.dbl());
+    output = absolute(output);
+    return amount * output;
+}
+
+mWh_t TraceCharger::getCharge()
+{
+    abort_if_unplugged(0);
+    return getCapacity();
+}
+
+mWh_t TraceCharger::getCapacity()
+{
+    return charge_cap;
+}
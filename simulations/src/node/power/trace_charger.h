@@ -0,0 +1,52 @@
+#ifndef TRACE_CHARGER_H
+#define TRACE_CHARGER_H
+
+#include "charger.h"
+#include "solar_trace.h"
+#include <omnetpp.h>
+#include <cstddef>
+
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * Charger whose output follows a recorded solar trace (see solar_trace.h).
+ *
+ * The trace file is memory mapped, so nodes sharing a trace share its pages.
+ * The output at a time is linearly interpolated between the samples around
+ * it. If loop is true, the trace is repeated once its end is reached,
+ * otherwise the output of its last sample is kept.
+*/
+class TraceCharger : public Charger{
+protected:
+    mWh_t charge_cap;
+    bool loop;
+
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+    const SolarTraceSample *samples = nullptr;
+    size_t count = 0;
+    // samples[cursor] is the last sample at or before the last time read
+    size_t cursor = 0;
+
+    double output_at(double t);
+
+public:
+    TraceCharger(const char *file_name, mWh_t charge_cap, bool loop = true);
+    ~TraceCharger();
+
+    /**
+     * The actual amount is the given amount scaled by the output of the
+     * trace at time t.
+    */
+    mWh_t discharge_at(simtime_t_cref t, mWh_t amount) override;
+
+    /**
+     * Returns the charge capacity of the charger.
+    */
+    mWh_t getCharge() override;
+
+    mWh_t getCapacity() override;
+};
+
+#endif // TRACE_CHARGER_H
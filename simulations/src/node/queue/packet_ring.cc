@@ -0,0 +1,47 @@
+#include "packet_ring.h"
+#include <algorithm>
+
+PacketRing::PacketRing(const char *name, size_t capacity) : cOwnedObject(name)
+{
+    slots.assign(capacity, nullptr);
+}
+
+PacketRing::~PacketRing()
+{
+    clear();
+}
+
+std::string PacketRing::str() const
+{
+    return "length=" + std::to_string(length) + " capacity=" + std::to_string(slots.size());
+}
+
+void PacketRing::forEachChild(cVisitor *v)
+{
+    for (size_t i = 0; i < length; i ++){
+        if (!v->visit(slots[wrap(head + i)]))
+            return;
+    }
+}
+
+size_t PacketRing::pop(DataMsg **out, size_t max_n)
+{
+    size_t n = min(max_n, length);
+
+    for (size_t i = 0; i < n; i ++){
+        out[i] = slots[wrap(head + i)];
+        drop(out[i]);
+    }
+    head = wrap(head + n);
+    length -= n;
+    return n;
+}
+
+void PacketRing::clear()
+{
+    for (size_t i = 0; i < length; i ++){
+        dropAndDelete(slots[wrap(head + i)]);
+    }
+    head = 0;
+    length = 0;
+}
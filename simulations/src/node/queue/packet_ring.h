@@ -0,0 +1,105 @@
+#ifndef PACKET_RING_H
+#define PACKET_RING_H
+
+#include <omnetpp.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "DataMsg_m.h"
+
+using namespace std;
+using namespace omnetpp;
+
+/**
+ * Bounded FIFO of data messages, stored in a contiguous ring of pointers.
+ *
+ * Messages are not copied: push() takes ownership of the message, like a cQueue
+ * does, and pop() releases it to the caller. A full or empty ring is reported
+ * through return values, so dropping packets under overload costs as much as
+ * accepting them.
+ * Messages still in the ring are deleted with it.
+*/
+class PacketRing : public cOwnedObject {
+
+  protected:
+    vector<DataMsg *> slots;
+    // index of the front message
+    size_t head = 0;
+    size_t length = 0;
+
+    size_t wrap(size_t index) const {
+      return index >= slots.size() ? index - slots.size() : index;
+    }
+
+  public:
+    PacketRing(const char *name, size_t capacity);
+    virtual ~PacketRing();
+
+    virtual std::string str() const override;
+    virtual void forEachChild(cVisitor *v) override;
+
+    /**
+     * Adds a message to the back of the ring and takes its ownership.
+     * Returns false, leaving the message to the caller, if the ring is full.
+    */
+    bool push(DataMsg *msg) {
+      if (length == slots.size())
+        return false;
+      take(msg);
+      slots[wrap(head + length)] = msg;
+      length ++;
+      return true;
+    }
+
+    /**
+     * Unlinks and returns the front message, or nullptr if the ring is empty.
+    */
+    DataMsg *pop() {
+      DataMsg *msg;
+
+      if (length == 0)
+        return nullptr;
+      msg = slots[head];
+      head = wrap(head + 1);
+      length --;
+      drop(msg);
+      return msg;
+    }
+
+    /**
+     * Unlinks up to max_n messages from the front of the ring and writes them
+     * to out, in order. Returns the number of messages written.
+    */
+    size_t pop(DataMsg **out, size_t max_n);
+
+    /**
+     * Returns the front message without unlinking it, or nullptr if the ring
+     * is empty.
+    */
+    DataMsg *front() const {
+      return length == 0 ? nullptr : slots[head];
+    }
+
+    size_t getLength() const {
+      return length;
+    }
+
+    size_t getCapacity() const {
+      return slots.size();
+    }
+
+    bool isEmpty() const {
+      return length == 0;
+    }
+
+    bool isFull() const {
+      return length == slots.size();
+    }
+
+    /**
+     * Deletes all the messages in the ring.
+    */
+    void clear();
+};
+
+#endif // PACKET_RING_H
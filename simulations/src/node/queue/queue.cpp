@@ -1,7 +1,8 @@
 #include "queue.h"
-#include <omnetpp/cqueue.h>
 #include "units.h"
 #include "statistics.h"
+#include "message_pool.h"
+#include <algorithm>
 #include <string>
 
 using namespace std;
@@ -9,66 +10,64 @@ using namespace std::string_literals;
 
 Define_Module(Queue);
 
-class QueuePacketDropPercentageStatisticListener : cListener
-{
-public:    
-
-    Queue *queue;
-    
-    simsignal_t pkt_drop_signal;
-    simsignal_t pkt_inbound_signal;
-    simsignal_t pkt_drop_perc_signal;
-
-    size_t pkt_drop_count = 0;
-    size_t pkt_inbound_count = 0;
-
-    QueuePacketDropPercentageStatisticListener(Queue *queue)
-    {
-        this->queue = queue;
-        pkt_drop_signal
-         = queue->registerSignal(queue->queue_pkt_drop_name);
-        pkt_inbound_signal
-         = queue->registerSignal(queue->queue_pkt_inbound_name);
-        pkt_drop_perc_signal
-         = queue->registerSignal(queue->queue_pkt_drop_perc_name);
-                
-        queue->subscribe(pkt_drop_signal, this);
-        queue->subscribe(pkt_inbound_signal, this);
-    }
-
-    virtual void receiveSignal(cComponent *src, simsignal_t id, 
-     intval_t value, cObject *details)
-    {
-        percentage_t pkt_drop_perc;
-        
-        if (id == pkt_drop_signal){
-            pkt_drop_count ++;
-        }
-        else if (id == pkt_inbound_signal){
-            pkt_inbound_count ++;
-        }
-
-        pkt_drop_perc = pkt_inbound_count? ((double) pkt_drop_count / pkt_inbound_count) * 100 : 0;
-        queue->measure_quantity_by_sid(pkt_drop_perc_signal, pkt_drop_perc);
-    }    
-};
-
 #define sample_and_send_queue_state(_queue_state_update)\
 {\
-    queue_state_update = new QueueStateUpdate();\
+    queue_state_update = acquire_msg<QueueStateUpdate>();\
     sample_queue_state(_queue_state_update);\
+    EV_DEBUG << "queue full at " << _queue_state_update->getBuffer_pop_percentage()\
+     << "%, num of dropped packets: " << _queue_state_update->getNum_of_dropped()\
+     << endl;\
+    /* the update may be released when written in place */\
     send_queue_state(_queue_state_update);   \
 }
 
-void Queue::initialize()
+void Queue::initialize(int stage)
 {    
-    init_module_params();
-    init_data_buffer();
-    init_statistic_templates();
+    switch (stage)
+    {
+    case 0:
+        init_module_params();
+        init_data_buffer();
+        init_statistic_templates();
+
+        EV_DEBUG << "Queue initialized with capacity "
+         << capacity << " and priority " << priority << endl;
+        break;
+    case 1:
+        // servers have initialized their queue states in stage 0
+        init_shared_states();
+        break;
+    default:
+        break;
+    }
+}
 
-    EV_DEBUG << "Queue initialized with capacity "
-     << capacity << " and priority " << priority << endl;
+void Queue::init_shared_states()
+{
+    const char *server_gate_array_name = "servers_inout$o";
+    int num_of_servers = gateSize(server_gate_array_name);
+    cGate *server_gate;
+    cModule *server;
+    QueueStatesOwner *owner;
+
+    shared_states.assign(num_of_servers, nullptr);
+    shared_state_idx.assign(num_of_servers, -1);
+    if (!shared_queue_state)
+        return;
 
+    // only servers of the same node can share their queue states
+    for (int i = 0; i < num_of_servers; i ++){
+        server_gate = gate(server_gate_array_name, i)->getPathEndGate();
+        server = server_gate->getOwnerModule();
+        owner = dynamic_cast<QueueStatesOwner *>(server);
+        if (owner == nullptr || server->getParentModule() != getParentModule())
+            continue;
+        shared_states[i] = owner->getSharedQueueStates();
+        shared_state_idx[i] = server_gate->getIndex();
+        if (shared_states[i] != nullptr)
+            EV_DEBUG << "Queue state shared with " << server->getFullPath()
+             << " as queue " << shared_state_idx[i] << endl;
+    }
 }
 
 void Queue::init_statistic_templates()
@@ -84,21 +83,24 @@ void Queue::init_statistic_templates()
      "queue%d_pkt_inbound", priority);
     init_statistic_template(queue_pkt_drop_perc_name,
      "queue_pkt_drop_percentage_over_time", "queue%d_pkt_drop_percentage", priority);
-    queuePacketDropPercentageStatisticListener
-     = new QueuePacketDropPercentageStatisticListener(this); 
-    
+    queue_pop_percentage_signal = registerSignal(queue_pop_percentage_name);
+    queue_time_signal = registerSignal(queue_time_name);
+    queue_pkt_drop_signal = registerSignal(queue_pkt_drop_name);
+    queue_pkt_inbound_signal = registerSignal(queue_pkt_inbound_name);
+    queue_pkt_drop_perc_signal = registerSignal(queue_pkt_drop_perc_name);
+    init_quantity_signals();
 }
 
 void Queue::init_module_params()
 {
     capacity = par("capacity").intValue();
     priority = par("priority").intValue();
+    shared_queue_state = par("shared_queue_state").boolValue();
 }
 
 void Queue::init_data_buffer()
 {
-    data_buffer =
-     new FixedCapCQueue(new PriorityCQueue(new cQueue(), priority),capacity);
+    data_buffer = new PacketRing("data_buffer", capacity);
 }
 
 void Queue::handleMessage(cMessage *msg)
@@ -107,19 +109,10 @@ void Queue::handleMessage(cMessage *msg)
         switch (msg->getKind())
         {
         case DATA_MSG:
+            // accepted messages are owned by the data buffer, dropped ones
+            // are released by drop_data()
             handleDataMsg((DataMsg *)msg);
-            /**
-             * FIXME: per qualche oscuro motivo, se non si cancella il messaggio dati
-             * anche quando è stato accettato e quindi accodato, si ha un memory leak.
-             * Questo non dovrebbe succedere perché, quando si invoca la delete sulla
-             * coda, in teoria dovrebbe distruggere tutti i messaggi accodati, e infatti
-             * lo fa. Tuttavia, rimane comunque un riferimento al messaggio dati.
-             * È come se il messaggio dati fosse duplicato quando è inserito nella coda,
-             * ma in teoria un oggetto cQueue non lo fa! (Nella documentazione e negli
-             * esempi non c'è traccia di un comportamento del genere).
-             * BOH!
-            */
-            break;
+            return;
         default:
             break;
         }
@@ -129,7 +122,8 @@ void Queue::handleMessage(cMessage *msg)
         {
         case QUEUE_DATA_REQUEST:
             handleQueueDataRequest((QueueDataRequest *)msg);
-            break;
+            release_msg((QueueDataRequest *)msg);
+            return;
         default:
             break;
         }
@@ -149,28 +143,21 @@ void Queue::handleDataMsg(DataMsg *msg)
     inbound ++;
 
     // tries to enqueue the message. If there is no space, drops the message.
-    try
-    {
-        accept_data(msg);
-    }
-    catch(const std::out_of_range& e)
-    {
+    if (!accept_data(msg))
         drop_data(msg);
-    }
 
-    measure_quantity("pkt_arrival_time", simTime().dbl());
-    measure_quantity(queue_pkt_inbound_name, 1);
+    measure_declared_quantity(pkt_arrival_time, simTime().dbl());
+    measure_quantity_by_sid(queue_pkt_inbound_signal, 1);
+    total_inbound ++;
+    measure_pkt_drop_percentage();
 
     // state might have changed, so we sample it and send it to servers
     sample_and_send_queue_state(queue_state_update);
-    EV_DEBUG << "queue full at " << queue_state_update->getBuffer_pop_percentage() 
-     << "%, num of dropped packets: " << queue_state_update->getNum_of_dropped() 
-     << endl;   
 }
 
 void Queue::handleQueueDataRequest(QueueDataRequest *msg)
 {
-    QueueDataResponse *queueDataResponse = new QueueDataResponse();
+    QueueDataResponse *queueDataResponse = acquire_msg<QueueDataResponse>();
 
     // try to fetch the desired number of packets from the queue
     fetch_data(queueDataResponse, msg->getData_n());
@@ -179,31 +166,45 @@ void Queue::handleQueueDataRequest(QueueDataRequest *msg)
     send_data(queueDataResponse, msg->getArrivalGate()->getOtherHalf());
 }
 
+void Queue::measure_pkt_drop_percentage()
+{
+    percentage_t pkt_drop_perc;
+
+    pkt_drop_perc = total_inbound ? ((double) total_dropped / total_inbound) * 100 : 0;
+    measure_quantity_by_sid(queue_pkt_drop_perc_signal, pkt_drop_perc);
+}
+
 void Queue::drop_data(DataMsg *msg)
 {
     EV_DEBUG << "Data message dropped: id=" << msg->getId() << endl;
     dropped ++;
 
-    measure_quantity(queue_pkt_drop_name, 1);
+    measure_quantity_by_sid(queue_pkt_drop_signal, 1);
+    total_dropped ++;
+    release_msg(msg);
 }
 
-void Queue::accept_data(DataMsg *msg)
+bool Queue::accept_data(DataMsg *msg)
 {
+    if (!data_buffer->push(msg))
+        return false;
     msg->setQueueing_time(msg->getArrivalTime());
-    data_buffer->insert(msg);
     EV_DEBUG << "Data message accepted: id=" << msg->getId() << endl;
+    return true;
 }
 
 void Queue::fetch_data(QueueDataResponse *response, size_t desired_n)
 {
-    try {
-        for (int i = 0; i < desired_n; i ++){
-            response->appendData((DataMsg *)data_buffer->pop());
-            measure_quantity(queue_time_name, simTime().dbl() - response->getData(i)->getQueueing_time());
-        }
-    }
-    catch (cRuntimeError e){
-        // not enough elements in queue, we return the ones we managed to fetch
+    size_t n;
+
+    // if there are not enough elements in queue, we return the ones we managed to fetch
+    fetched_data.resize(min(desired_n, data_buffer->getLength()));
+    n = data_buffer->pop(fetched_data.data(), fetched_data.size());
+
+    response->setDataArraySize(n);
+    for (size_t i = 0; i < n; i ++){
+        response->setData(i, fetched_data[i]);
+        measure_quantity_by_sid(queue_time_signal, simTime().dbl() - fetched_data[i]->getQueueing_time());
     }
 }
 
@@ -211,9 +212,15 @@ void Queue::send_data(QueueDataResponse *response, cGate *server_gate)
 {
     QueueStateUpdate *queueStateUpdate;
 
-    queueStateUpdate = new QueueStateUpdate();
+    queueStateUpdate = acquire_msg<QueueStateUpdate>();
     sample_queue_state(queueStateUpdate);
-    response->setStateUpdate(queueStateUpdate);
+    // a server sharing the queue states gets no piggybacked update
+    if (shared_states[server_gate->getIndex()] != nullptr){
+        write_shared_state(queueStateUpdate, server_gate->getIndex());
+        release_msg(queueStateUpdate);
+    }
+    else
+        response->setStateUpdate(queueStateUpdate);
 
     EV_DEBUG << "Sending " << response->getDataArraySize() << " data messages to server" << endl;
 
@@ -225,7 +232,7 @@ void Queue::sample_queue_state(QueueStateUpdate *msg)
     percentage_t buffer_pop_percentage;
 
     buffer_pop_percentage = (capacity == 0) ? 100.0 : data_buffer->getLength() * 100.0 / capacity;
-    measure_quantity(queue_pop_percentage_name, buffer_pop_percentage);
+    measure_quantity_by_sid(queue_pop_percentage_signal, buffer_pop_percentage);
     
     // calcs percentage of queue occupation
     msg->setBuffer_pop_percentage(buffer_pop_percentage);
@@ -244,13 +251,40 @@ void Queue::send_queue_state(QueueStateUpdate *msg)
     int server_port_id_start;
     int num_of_servers;
     const char *server_gate_array_name = "servers_inout$o";
+    QueueStateUpdate *copy;
+    int last_msg_server = -1;
 
-    // Sends queue state update to all servers connected to it
+    // Writes the state in place for the servers sharing the queue states
+    // and sends queue state update to all the other servers connected to it
     server_port_id_start = gateBaseId(server_gate_array_name);
     num_of_servers = gateSize(server_gate_array_name);
     for (int i = 0; i < num_of_servers; i ++){
-        send(i == num_of_servers - 1 ? msg : msg->dup(), server_port_id_start + i); 
+        if (shared_states[i] != nullptr)
+            write_shared_state(msg, i);
+        else
+            last_msg_server = i;
     }
+    for (int i = 0; i < last_msg_server; i ++){
+        if (shared_states[i] != nullptr)
+            continue;
+        copy = acquire_msg<QueueStateUpdate>();
+        *copy = *msg;
+        send(copy, server_port_id_start + i);
+    }
+    if (last_msg_server >= 0)
+        send(msg, server_port_id_start + last_msg_server);
+    else
+        release_msg(msg);
+}
+
+void Queue::write_shared_state(QueueStateUpdate *msg, int server)
+{
+    QueueStates *states = shared_states[server];
+    int queue_idx = shared_state_idx[server];
+
+    states->update(queue_idx, msg->getBuffer_pop_percentage(),
+     msg->getNum_of_dropped(), msg->getNum_of_inbound());
+    states->mark_changed(queue_idx);
 }
 
 Queue::~Queue()
@@ -0,0 +1,105 @@
+#ifndef QUEUE_STATE_H
+#define QUEUE_STATE_H
+
+#include <vector>
+#include <algorithm>
+#include "units.h"
+
+using namespace std;
+
+/**
+ * Up-to-date state of the queues, as tracked by the controller.
+ *
+ * States are stored as a structure of arrays: the i-th element of each array
+ * belongs to the i-th queue. Keeping each quantity contiguous lets the reward
+ * kernel process many queues at once.
+*/
+struct QueueStates {
+  vector<percentage_t> occupancy;
+  vector<int> pkt_drop_cnt;
+  vector<int> pkt_inbound_cnt;
+  vector<int> max_pkt_drop_cnt;
+  // priority of the queue, as seen by the reward terms
+  vector<float> priority;
+
+  /**
+   * Queues whose state was written in place since the last call to
+   * take_changed(): changed_queues lists the queues whose flag in changed
+   * is set.
+  */
+  vector<bool> changed;
+  vector<int> changed_queues;
+
+  void resize(size_t num_queues){
+    occupancy.resize(num_queues, 0);
+    pkt_drop_cnt.resize(num_queues, 0);
+    pkt_inbound_cnt.resize(num_queues, 0);
+    max_pkt_drop_cnt.resize(num_queues, 0);
+    changed.resize(num_queues, false);
+    priority.resize(num_queues);
+    for (size_t i = 0; i < num_queues; i ++){
+      priority[i] = i + 1;
+    }
+  }
+
+  size_t size() const {
+    return occupancy.size();
+  }
+
+  /**
+   * Applies a queue state update to the i-th queue.
+  */
+  void update(size_t i, percentage_t occupancy, int num_of_dropped, int num_of_inbound){
+    this->occupancy[i] = occupancy;
+    pkt_drop_cnt[i] += num_of_dropped;
+    pkt_inbound_cnt[i] += num_of_inbound;
+    if (pkt_drop_cnt[i] > max_pkt_drop_cnt[i])
+      max_pkt_drop_cnt[i] = pkt_drop_cnt[i];
+  }
+
+  void mark_changed(size_t i){
+    if (!changed[i]){
+      changed[i] = true;
+      changed_queues.push_back(i);
+    }
+  }
+
+  /**
+   * Calls f(i) for each queue changed since the last call, then forgets them.
+  */
+  template <class F>
+  void take_changed(F f){
+    for (int i : changed_queues){
+      changed[i] = false;
+      f(i);
+    }
+    changed_queues.clear();
+  }
+
+  void reset_counts(size_t i){
+    pkt_drop_cnt[i] = 0;
+    pkt_inbound_cnt[i] = 0;
+  }
+
+  void reset_counts(){
+    fill(pkt_drop_cnt.begin(), pkt_drop_cnt.end(), 0);
+    fill(pkt_inbound_cnt.begin(), pkt_inbound_cnt.end(), 0);
+  }
+};
+
+/**
+ * Implemented by the modules that let their queues write the queue states in
+ * place, instead of sending them QueueStateUpdate messages.
+*/
+class QueueStatesOwner {
+  public:
+    virtual ~QueueStatesOwner() {}
+
+    /**
+     * Returns the states the queues can write in place, or nullptr if the
+     * module expects messages.
+    */
+    virtual QueueStates *getSharedQueueStates() = 0;
+};
+
+#endif // QUEUE_STATE_H
@@ -0,0 +1,379 @@
+#include "reward_engine.h"
+
+RewardEngine::RewardEngine(cValueMap *reward_term_models, int num_queues,
+ const vector<reward_t> &power_sources_costs)
+ : num_queues(num_queues), power_sources_costs(power_sources_costs)
+{
+    RewardTerm *term;
+
+    sum_priorities = ((num_queues * (num_queues + 1))/2);
+    sum_power_sources_costs = 0;
+    for (reward_t cost : power_sources_costs){
+        sum_power_sources_costs += cost;
+    }
+
+    // norm terms are not normalized and have unitary weight
+    energy_penalty_norm_term = new RewardTerm(reward_term_models, "energy_penalty");
+    energy_penalty_norm_term->setWeight(1);
+    energy_consumed_slot = energy_penalty_norm_term->bind_slot("energy_consumed");
+    cost_per_mWh_slot = energy_penalty_norm_term->bind_slot("cost_per_mWh");
+    energy_penalty_norm_term->set_slot(cost_per_mWh_slot, sum_power_sources_costs);
+
+    queue_occ_penalty_norm_term = new RewardTerm(reward_term_models, "queue_occ_penalty");
+    queue_occ_penalty_norm_term->setWeight(1);
+    queue_occ_priority_slot = queue_occ_penalty_norm_term->bind_slot("priority");
+    queue_occ_slot = queue_occ_penalty_norm_term->bind_slot("queue_occ");
+    queue_occ_penalty_norm_term->set_slot(queue_occ_priority_slot, sum_priorities);
+    //100 cause it's the max value, used for normalization
+    queue_occ_penalty_norm_term->set_slot(queue_occ_slot, 100);
+
+    pkt_drop_penalty_norm_term = new RewardTerm(reward_term_models, "pkt_drop_penalty");
+    pkt_drop_penalty_norm_term->setWeight(1);
+    pkt_drop_priority_slot = pkt_drop_penalty_norm_term->bind_slot("priority");
+    pkt_drop_count_slot = pkt_drop_penalty_norm_term->bind_slot("pkt_drop_count");
+    pkt_drop_penalty_norm_term->set_slot(pkt_drop_priority_slot, sum_priorities);
+
+    // energy terms, one for each power source
+    energy_penalty_normalizers.resize(power_sources_costs.size());
+    for (int i = 0; i < power_sources_costs.size(); i ++){
+        term = make_term(reward_term_models, "energy_penalty",
+         &energy_penalty_normalizers[i]);
+        term->bind_slot("energy_consumed");
+        term->bind_slot("cost_per_mWh");
+        term->set_slot(cost_per_mWh_slot, power_sources_costs[i]);
+        energy_penalty_terms.push_back(term);
+    }
+
+    // queue occ penalties and pkt drop penalties, one term for each priority
+    queue_occ_penalty_normalizers.resize(num_queues);
+    pkt_drop_penalty_normalizers.resize(num_queues);
+    for (int queue = 0; queue < num_queues; queue ++){
+        term = make_term(reward_term_models, "queue_occ_penalty",
+         &queue_occ_penalty_normalizers[queue]);
+        term->bind_slot("priority");
+        term->bind_slot("queue_occ");
+        term->set_slot(queue_occ_priority_slot, queue + 1);
+        queue_occ_penalty_terms.push_back(term);
+
+        term = make_term(reward_term_models, "pkt_drop_penalty",
+         &pkt_drop_penalty_normalizers[queue]);
+        term->bind_slot("priority");
+        term->bind_slot("pkt_drop_count");
+        term->set_slot(pkt_drop_priority_slot, queue + 1);
+        pkt_drop_penalty_terms.push_back(term);
+    }
+
+    // incremental mode state: all the queue terms must be evaluated at least once,
+    // while the queue occ norm factor never changes
+    queue_dirty.resize(num_queues, false);
+    // a queue can be listed twice at most, i.e. when it's marked again while
+    // its terms are being re-evaluated
+    dirty_queues.reserve(2 * num_queues);
+    queue_terms_values.resize(num_queues, 0);
+    for (int queue = 0; queue < num_queues; queue ++){
+        mark_queue_dirty(queue);
+    }
+    queue_occ_norm_factor = queue_occ_penalty_norm_term->compute(false);
+    for (MinMaxNormalizer *normalizer : queue_occ_penalty_normalizers){
+        normalizer->setRange(0, absolute(queue_occ_norm_factor));
+    }
+    energy_norm_inputs.resize(power_sources_costs.size(), -1);
+    energy_norm_factors.resize(power_sources_costs.size(), 0);
+
+    EV_DEBUG << "Reward engine built with " << energy_penalty_terms.size()
+     << " energy terms and " << num_queues << " queue terms for each queue model" << endl;
+}
+
+RewardTerm *RewardEngine::make_term(cValueMap *reward_term_models,
+ const char *reward_term_model_name, MinMaxNormalizer **normalizer)
+{
+    RewardTerm *term;
+
+    term = new RewardTerm(reward_term_models, reward_term_model_name);
+    *normalizer = new MinMaxNormalizer(0, 0);
+    term->setNormalizer(*normalizer);
+
+    return term;
+}
+
+reward_t RewardEngine::compute(const vector<mWh_t> &last_energy_consumed,
+ const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states)
+{
+    if (kernel)
+        return compute_kernel(last_energy_consumed, max_energy_consumed, queue_states);
+    if (incremental)
+        return compute_incremental(last_energy_consumed, max_energy_consumed, queue_states);
+    return compute_full(last_energy_consumed, max_energy_consumed, queue_states);
+}
+
+reward_t RewardEngine::compute_energy_terms(const vector<mWh_t> &last_energy_consumed,
+ const vector<mWh_t> &max_energy_consumed)
+{
+    reward_t reward = 0;
+    reward_t norm_factor;
+    reward_t term_value;
+
+    for (int i = 0; i < energy_penalty_terms.size(); i ++){
+        // norm factor changes only when a new max energy consumption is seen
+        if (!incremental || max_energy_consumed[i] != energy_norm_inputs[i]){
+            energy_norm_factors[i] = energy_penalty_norm_term
+             ->set_slot(energy_consumed_slot, max_energy_consumed[i])->compute(false);
+            energy_norm_inputs[i] = max_energy_consumed[i];
+            energy_penalty_normalizers[i]->setRange(0, absolute(energy_norm_factors[i]));
+        }
+        norm_factor = energy_norm_factors[i];
+
+        term_value = energy_penalty_terms[i]
+         ->set_slot(energy_consumed_slot, last_energy_consumed[i])->compute(false);
+        reward = reward + term_value;
+
+        EV_DEBUG << "energy term for power source " << i << ": " << term_value
+         << " (norm factor " << norm_factor << ")" << endl;
+    }
+
+    return reward;
+}
+
+reward_t RewardEngine::compute_queue_terms(int queue, QueueStates &queue_states)
+{
+    reward_t norm_factor;
+    reward_t queue_occ_value;
+    reward_t pkt_drop_value;
+
+    queue_occ_value = queue_occ_penalty_terms[queue]
+     ->set_slot(queue_occ_slot, queue_states.occupancy[queue])->compute(false);
+
+    norm_factor = pkt_drop_penalty_norm_term
+     ->set_slot(pkt_drop_count_slot, queue_states.pkt_inbound_cnt[queue])->compute(false);
+    pkt_drop_penalty_normalizers[queue]->setRange(0, absolute(norm_factor));
+    pkt_drop_value = pkt_drop_penalty_terms[queue]
+     ->set_slot(pkt_drop_count_slot, queue_states.pkt_drop_cnt[queue])->compute(false);
+
+    EV_DEBUG << "queue terms for priority " << queue << ": occ " << queue_occ_value
+     << ", pkt drop " << pkt_drop_value << " (norm factor " << norm_factor << ")" << endl;
+
+    return queue_occ_value + pkt_drop_value;
+}
+
+reward_t RewardEngine::compute_full(const vector<mWh_t> &last_energy_consumed,
+ const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states)
+{
+    reward_t reward = 0;
+    reward_t norm_factor;
+    reward_t term_value;
+
+    reward = compute_energy_terms(last_energy_consumed, max_energy_consumed);
+
+    // queue occ terms share the same norm factor, since it depends only on the
+    // sum of priorities
+    norm_factor = queue_occ_penalty_norm_term->compute(false);
+    for (int queue = 0; queue < num_queues; queue ++){
+        queue_occ_penalty_normalizers[queue]->setRange(0, absolute(norm_factor));
+
+        term_value = queue_occ_penalty_terms[queue]
+         ->set_slot(queue_occ_slot, queue_states.occupancy[queue])->compute(false);
+        reward = reward + term_value;
+
+        EV_DEBUG << "queue occ term for priority " << queue << ": " << term_value
+         << " (norm factor " << norm_factor << ")" << endl;
+    }
+
+    // pkt drop terms
+    for (int queue = 0; queue < num_queues; queue ++){
+        norm_factor = pkt_drop_penalty_norm_term
+         ->set_slot(pkt_drop_count_slot, queue_states.pkt_inbound_cnt[queue])->compute(false);
+        pkt_drop_penalty_normalizers[queue]->setRange(0, absolute(norm_factor));
+
+        term_value = pkt_drop_penalty_terms[queue]
+         ->set_slot(pkt_drop_count_slot, queue_states.pkt_drop_cnt[queue])->compute(false);
+        reward = reward + term_value;
+
+        // resets pkt counts after reading them
+        queue_states.reset_counts(queue);
+
+        EV_DEBUG << "pkt drop term for priority " << queue << ": " << term_value
+         << " (norm factor " << norm_factor << ")" << endl;
+    }
+
+    return reward;
+}
+
+reward_t RewardEngine::compute_incremental(const vector<mWh_t> &last_energy_consumed,
+ const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states)
+{
+    reward_t value;
+    bool had_counts;
+    size_t num_dirty = dirty_queues.size();
+
+    // re-evaluates only the terms of the queues that changed since last computation.
+    // Queues appended while iterating (i.e. the ones whose counts get reset) are
+    // left for the next computation.
+    for (size_t i = 0; i < num_dirty; i ++){
+        int queue = dirty_queues[i];
+
+        value = compute_queue_terms(queue, queue_states);
+        queue_terms_sum += (double) value - queue_terms_values[queue];
+        queue_terms_values[queue] = value;
+
+        // resetting the counts changes the state of the queue, so its terms must be
+        // re-evaluated next time even if no update is received in the meanwhile
+        had_counts = queue_states.pkt_drop_cnt[queue] != 0
+         || queue_states.pkt_inbound_cnt[queue] != 0;
+        queue_states.reset_counts(queue);
+        queue_dirty[queue] = false;
+        if (had_counts)
+            mark_queue_dirty(queue);
+    }
+    dirty_queues.erase(dirty_queues.begin(), dirty_queues.begin() + num_dirty);
+
+    if (++computations_since_resync == REWARD_RESYNC_PERIOD){
+        queue_terms_sum = 0;
+        for (reward_t queue_terms_value : queue_terms_values){
+            queue_terms_sum += queue_terms_value;
+        }
+        computations_since_resync = 0;
+    }
+
+    EV_DEBUG << "re-evaluated terms of " << num_dirty << " queues out of "
+     << num_queues << endl;
+
+    return compute_energy_terms(last_energy_consumed, max_energy_consumed)
+     + (reward_t) queue_terms_sum;
+}
+
+reward_t RewardEngine::compute_kernel(const vector<mWh_t> &last_energy_consumed,
+ const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states)
+{
+    reward_t queue_terms;
+
+    queue_terms = compute_queue_penalties(kernel_coeffs, queue_states);
+
+    EV_DEBUG << "queue terms computed by " << queue_penalties_kernel_name()
+     << " kernel: " << queue_terms << endl;
+
+    return compute_energy_terms(last_energy_consumed, max_energy_consumed) + queue_terms;
+}
+
+reward_t RewardEngine::probe_linear_factor(RewardTerm *norm_term, int priority_slot,
+ int quantity_slot, bool &linear)
+{
+    // (priority, quantity) pairs the signal is evaluated at
+    static const double probes[][2] = {{2, 3}, {5, 0.5}, {7, 11}, {0, 13}, {17, 0}};
+    reward_t k;
+    reward_t value;
+    reward_t expected;
+    reward_t error;
+    reward_t tolerance;
+
+    k = norm_term->set_slot(priority_slot, 1)->set_slot(quantity_slot, 1)->compute(false);
+    for (auto &probe : probes){
+        value = norm_term->set_slot(priority_slot, probe[0])
+         ->set_slot(quantity_slot, probe[1])->compute(false);
+        expected = k * probe[0] * probe[1];
+        error = value - expected;
+        tolerance = REWARD_LINEARITY_TOLERANCE * (1 + (absolute(expected)));
+        if ((absolute(error)) > tolerance){
+            linear = false;
+            EV_DEBUG << "signal " << norm_term->getSignal()->str()
+             << " is not linear in priority * quantity" << endl;
+        }
+    }
+
+    return k;
+}
+
+bool RewardEngine::setKernel(bool kernel)
+{
+    bool linear = true;
+    reward_t k_occ;
+    reward_t k_drop;
+    reward_t occ_weight;
+    reward_t drop_weight;
+    reward_t drop_norm_factor;
+
+    this->kernel = false;
+    if (!kernel)
+        return false;
+    if (incremental)
+        throw cRuntimeError("Kernel mode cannot be combined with incremental mode");
+    if (num_queues == 0)
+        return false;
+
+    k_occ = probe_linear_factor(queue_occ_penalty_norm_term, queue_occ_priority_slot,
+     queue_occ_slot, linear);
+    k_drop = probe_linear_factor(pkt_drop_penalty_norm_term, pkt_drop_priority_slot,
+     pkt_drop_count_slot, linear);
+
+    // restores the norm term slots changed by the probes
+    queue_occ_penalty_norm_term->set_slot(queue_occ_priority_slot, sum_priorities);
+    queue_occ_penalty_norm_term->set_slot(queue_occ_slot, 100);
+    pkt_drop_penalty_norm_term->set_slot(pkt_drop_priority_slot, sum_priorities);
+
+    if (!linear)
+        return false;
+
+    // same norm factors the normalizers would use, see compute_full()
+    occ_weight = queue_occ_penalty_terms[0]->getWeight();
+    drop_weight = pkt_drop_penalty_terms[0]->getWeight();
+    drop_norm_factor = k_drop * sum_priorities;
+    kernel_coeffs.occ_coeff = queue_occ_norm_factor == 0 ? 0
+     : occ_weight * k_occ / (absolute(queue_occ_norm_factor));
+    kernel_coeffs.drop_coeff = drop_norm_factor == 0 ? 0
+     : drop_weight * k_drop / (absolute(drop_norm_factor));
+
+    EV_DEBUG << "Reward kernel mode enabled (" << queue_penalties_kernel_name()
+     << "), occ coeff " << kernel_coeffs.occ_coeff << ", drop coeff "
+     << kernel_coeffs.drop_coeff << endl;
+
+    this->kernel = true;
+    return true;
+}
+
+vector<RewardTerm *> RewardEngine::all_terms() const
+{
+    vector<RewardTerm *> terms = {energy_penalty_norm_term, queue_occ_penalty_norm_term,
+     pkt_drop_penalty_norm_term};
+
+    terms.insert(terms.end(), energy_penalty_terms.begin(), energy_penalty_terms.end());
+    terms.insert(terms.end(), queue_occ_penalty_terms.begin(), queue_occ_penalty_terms.end());
+    terms.insert(terms.end(), pkt_drop_penalty_terms.begin(), pkt_drop_penalty_terms.end());
+    return terms;
+}
+
+int RewardEngine::setCompiledSignals(bool compiled_signals)
+{
+    int num_compiled = 0;
+    string error;
+
+    this->compiled_signals = compiled_signals;
+    for (RewardTerm *term : all_terms()){
+        if (!compiled_signals){
+            term->decompile();
+            continue;
+        }
+        if (term->compile(error)){
+            num_compiled++;
+        } else {
+            EV_DEBUG << "signal " << term->getSignal()->str() << " not compiled: "
+             << error << endl;
+        }
+    }
+
+    EV_DEBUG << num_compiled << " reward term signals compiled" << endl;
+
+    return num_compiled;
+}
+
+RewardEngine::~RewardEngine()
+{
+    delete energy_penalty_norm_term;
+    delete queue_occ_penalty_norm_term;
+    delete pkt_drop_penalty_norm_term;
+
+    for (RewardTerm *term : energy_penalty_terms)
+        delete term;
+    for (RewardTerm *term : queue_occ_penalty_terms)
+        delete term;
+    for (RewardTerm *term : pkt_drop_penalty_terms)
+        delete term;
+}
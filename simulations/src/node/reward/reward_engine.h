@@ -0,0 +1,178 @@
+#ifndef REWARD_ENGINE_H
+#define REWARD_ENGINE_H
+
+#include <omnetpp.h>
+#include <vector>
+#include "units.h"
+#include "reward_term.h"
+#include "node/queue_state.h"
+#include "reward_kernel.h"
+
+using namespace omnetpp;
+using namespace std;
+
+// In incremental mode the reward sum is recomputed from scratch every this
+// many computations, so that rounding errors of the updates do not pile up.
+#define REWARD_RESYNC_PERIOD 1024
+
+// Relative tolerance of the check of the linearity of queue term signals
+#define REWARD_LINEARITY_TOLERANCE 1e-6
+
+/**
+ * Computes the reward of the controller by combining the reward terms built from the
+ * reward term models.
+ *
+ * All the terms are built once when the engine is created: one energy term for each
+ * power source, one queue occupancy term and one pkt drop term for each queue, plus
+ * one term for each model used to compute the normalization factors.
+ * Symbols of the signals are bound to slots, so each computation only writes the
+ * measured quantities in the slots and evaluates the terms, with no allocation.
+ *
+ * In incremental mode, queue terms are re-evaluated only for the queues marked
+ * dirty since the last computation, and their sum is updated with the difference
+ * between the new and the old values. Norm factors are cached until their inputs
+ * change.
+ *
+ * In kernel mode, queue terms are computed all at once by a vectorized kernel
+ * instead of evaluating the signals. This is possible only when the queue
+ * term signals are linear in the product of the priority and the measured
+ * quantity, which is checked when the mode is enabled.
+*/
+class RewardEngine {
+
+  protected:
+    int num_queues;
+    int sum_priorities;
+    reward_t sum_power_sources_costs;
+    vector<reward_t> power_sources_costs;
+
+    /**
+     * To normalize the reward terms, we need to know the maximum value
+     * for each term. To compute it, we must leverage the same signal used by the
+     * corresponding reward term. So we keep a norm term for each model, whose
+     * signal is evaluated at the maximum possible value of the symbols.
+    */
+    RewardTerm *energy_penalty_norm_term;
+    RewardTerm *queue_occ_penalty_norm_term;
+    RewardTerm *pkt_drop_penalty_norm_term;
+
+    vector<RewardTerm *> energy_penalty_terms;
+    vector<RewardTerm *> queue_occ_penalty_terms;
+    vector<RewardTerm *> pkt_drop_penalty_terms;
+
+    // normalizers are owned by the corresponding terms
+    vector<MinMaxNormalizer *> energy_penalty_normalizers;
+    vector<MinMaxNormalizer *> queue_occ_penalty_normalizers;
+    vector<MinMaxNormalizer *> pkt_drop_penalty_normalizers;
+
+    /**
+     * Slot indexes of the symbols. Terms built from the same model bind their
+     * symbols in the same order, so they share the slot indexes.
+    */
+    int energy_consumed_slot;
+    int cost_per_mWh_slot;
+    int queue_occ_priority_slot;
+    int queue_occ_slot;
+    int pkt_drop_priority_slot;
+    int pkt_drop_count_slot;
+
+    /**
+     * Incremental mode state:
+    */
+    bool incremental = false;
+    // dirty_queues lists the queues whose flag in queue_dirty is set
+    vector<bool> queue_dirty;
+    vector<int> dirty_queues;
+    vector<reward_t> queue_terms_values;
+    double queue_terms_sum = 0;
+    unsigned int computations_since_resync = 0;
+    reward_t queue_occ_norm_factor;
+    vector<mWh_t> energy_norm_inputs;
+    vector<reward_t> energy_norm_factors;
+    /* Incremental mode state (END)*/
+
+    bool kernel = false;
+    QueuePenaltyCoeffs kernel_coeffs;
+
+    bool compiled_signals = false;
+
+    /**
+     * Returns all the terms built by the engine, norm terms included.
+    */
+    vector<RewardTerm *> all_terms() const;
+
+    RewardTerm *make_term(cValueMap *reward_term_models, const char *reward_term_model_name,
+     MinMaxNormalizer **normalizer);
+
+    reward_t compute_energy_terms(const vector<mWh_t> &last_energy_consumed,
+     const vector<mWh_t> &max_energy_consumed);
+    reward_t compute_queue_terms(int queue, QueueStates &queue_states);
+    reward_t compute_full(const vector<mWh_t> &last_energy_consumed,
+     const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states);
+    reward_t compute_incremental(const vector<mWh_t> &last_energy_consumed,
+     const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states);
+    reward_t compute_kernel(const vector<mWh_t> &last_energy_consumed,
+     const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states);
+
+    /**
+     * Returns the factor k such that signal(priority, x) = k * priority * x
+     * for the given norm term, or sets linear to false if there is no such k.
+    */
+    reward_t probe_linear_factor(RewardTerm *norm_term, int priority_slot, int quantity_slot,
+     bool &linear);
+
+  public:
+    RewardEngine(cValueMap *reward_term_models, int num_queues,
+     const vector<reward_t> &power_sources_costs);
+    ~RewardEngine();
+
+    void setIncremental(bool incremental) {
+      this->incremental = incremental;
+    }
+
+    bool isIncremental() const {
+      return incremental;
+    }
+
+    /**
+     * Compiles the signals of all the terms to native programs, or goes back
+     * to interpreting them. Terms whose signal cannot be compiled keep being
+     * interpreted. Returns the number of compiled terms.
+    */
+    int setCompiledSignals(bool compiled_signals);
+
+    bool hasCompiledSignals() const {
+      return compiled_signals;
+    }
+
+    /**
+     * Enables the kernel mode, if the queue term signals allow it.
+     * Returns whether kernel mode is enabled. Kernel mode cannot be combined
+     * with the incremental one.
+    */
+    bool setKernel(bool kernel);
+
+    bool isKernel() const {
+      return kernel;
+    }
+
+    /**
+     * Marks the state of a queue as changed since the last computation.
+     * Only relevant in incremental mode.
+    */
+    void mark_queue_dirty(int queue) {
+      if (!queue_dirty[queue]){
+        queue_dirty[queue] = true;
+        dirty_queues.push_back(queue);
+      }
+    }
+
+    /**
+     * Computes the reward for the last action.
+     * Pkt counts of the queue states are reset after being read.
+    */
+    reward_t compute(const vector<mWh_t> &last_energy_consumed,
+     const vector<mWh_t> &max_energy_consumed, QueueStates &queue_states);
+};
+
+#endif // REWARD_ENGINE_H
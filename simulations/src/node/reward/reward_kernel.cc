@@ -0,0 +1,112 @@
+#include "reward_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REWARD_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+reward_t compute_queue_penalties_scalar(const QueuePenaltyCoeffs &coeffs,
+ QueueStates &queue_states)
+{
+    size_t num_queues = queue_states.size();
+    const percentage_t *occupancy = queue_states.occupancy.data();
+    const float *priority = queue_states.priority.data();
+    int *pkt_drop_cnt = queue_states.pkt_drop_cnt.data();
+    int *pkt_inbound_cnt = queue_states.pkt_inbound_cnt.data();
+    double sum = 0;
+
+    for (size_t i = 0; i < num_queues; i ++){
+        sum += coeffs.occ_coeff * priority[i] * occupancy[i];
+        // a zero norm factor makes the term zero, as MinMaxNormalizer does
+        if (pkt_inbound_cnt[i] > 0)
+            sum += coeffs.drop_coeff * priority[i] * pkt_drop_cnt[i] / pkt_inbound_cnt[i];
+        pkt_drop_cnt[i] = 0;
+        pkt_inbound_cnt[i] = 0;
+    }
+
+    return sum;
+}
+
+#ifdef REWARD_KERNEL_AVX2
+
+__attribute__((target("avx2")))
+static reward_t compute_queue_penalties_avx2(const QueuePenaltyCoeffs &coeffs,
+ QueueStates &queue_states)
+{
+    size_t num_queues = queue_states.size();
+    const percentage_t *occupancy = queue_states.occupancy.data();
+    const float *priority = queue_states.priority.data();
+    int *pkt_drop_cnt = queue_states.pkt_drop_cnt.data();
+    int *pkt_inbound_cnt = queue_states.pkt_inbound_cnt.data();
+    const __m256 occ_coeff = _mm256_set1_ps(coeffs.occ_coeff);
+    const __m256 drop_coeff = _mm256_set1_ps(coeffs.drop_coeff);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i zero_counts = _mm256_setzero_si256();
+    __m256 acc = _mm256_setzero_ps();
+    float lanes[8];
+    double sum = 0;
+    size_t i;
+
+    for (i = 0; i + 8 <= num_queues; i += 8){
+        __m256 occ = _mm256_loadu_ps(occupancy + i);
+        __m256 prio = _mm256_loadu_ps(priority + i);
+        __m256 dropped = _mm256_cvtepi32_ps(
+         _mm256_loadu_si256((const __m256i *)(pkt_drop_cnt + i)));
+        __m256 inbound = _mm256_cvtepi32_ps(
+         _mm256_loadu_si256((const __m256i *)(pkt_inbound_cnt + i)));
+
+        __m256 occ_term = _mm256_mul_ps(_mm256_mul_ps(occ_coeff, prio), occ);
+        __m256 drop_term = _mm256_div_ps(
+         _mm256_mul_ps(_mm256_mul_ps(drop_coeff, prio), dropped), inbound);
+        // lanes without inbound pkts would be inf or nan, they contribute zero
+        drop_term = _mm256_blendv_ps(zero, drop_term,
+         _mm256_cmp_ps(inbound, zero, _CMP_GT_OQ));
+
+        acc = _mm256_add_ps(acc, _mm256_add_ps(occ_term, drop_term));
+
+        _mm256_storeu_si256((__m256i *)(pkt_drop_cnt + i), zero_counts);
+        _mm256_storeu_si256((__m256i *)(pkt_inbound_cnt + i), zero_counts);
+    }
+
+    _mm256_storeu_ps(lanes, acc);
+    for (int lane = 0; lane < 8; lane ++){
+        sum += lanes[lane];
+    }
+
+    // remaining queues
+    for (; i < num_queues; i ++){
+        sum += coeffs.occ_coeff * priority[i] * occupancy[i];
+        if (pkt_inbound_cnt[i] > 0)
+            sum += coeffs.drop_coeff * priority[i] * pkt_drop_cnt[i] / pkt_inbound_cnt[i];
+        pkt_drop_cnt[i] = 0;
+        pkt_inbound_cnt[i] = 0;
+    }
+
+    return sum;
+}
+
+static bool cpu_has_avx2()
+{
+    static bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#endif // REWARD_KERNEL_AVX2
+
+reward_t compute_queue_penalties(const QueuePenaltyCoeffs &coeffs, QueueStates &queue_states)
+{
+#ifdef REWARD_KERNEL_AVX2
+    if (cpu_has_avx2())
+        return compute_queue_penalties_avx2(coeffs, queue_states);
+#endif
+    return compute_queue_penalties_scalar(coeffs, queue_states);
+}
+
+const char *queue_penalties_kernel_name()
+{
+#ifdef REWARD_KERNEL_AVX2
+    if (cpu_has_avx2())
+        return "avx2";
+#endif
+    return "scalar";
+}
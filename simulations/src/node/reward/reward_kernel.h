@@ -0,0 +1,37 @@
+#ifndef REWARD_KERNEL_H
+#define REWARD_KERNEL_H
+
+#include "units.h"
+#include "node/queue_state.h"
+
+/**
+ * Coefficients of the queue terms, for signals that are linear in the product
+ * of the queue priority and the measured quantity (i.e. k * priority * x).
+ *
+ * With such signals, a normalized term reduces to
+ *  queue occ:  occ_coeff * priority * occupancy
+ *  pkt drop:   drop_coeff * priority * pkt_drop_cnt / pkt_inbound_cnt
+ * where the coefficients fold in the weight, k and the norm factor.
+*/
+struct QueuePenaltyCoeffs {
+  float occ_coeff;
+  float drop_coeff;
+};
+
+/**
+ * Computes the sum of all the normalized queue occ and pkt drop terms in a
+ * single pass over the queue states, and resets the pkt counts.
+ *
+ * The AVX2 implementation is used when the CPU supports it, the scalar one
+ * otherwise.
+*/
+reward_t compute_queue_penalties(const QueuePenaltyCoeffs &coeffs, QueueStates &queue_states);
+reward_t compute_queue_penalties_scalar(const QueuePenaltyCoeffs &coeffs,
+ QueueStates &queue_states);
+
+/**
+ * Returns the name of the implementation used by compute_queue_penalties().
+*/
+const char *queue_penalties_kernel_name();
+
+#endif // REWARD_KERNEL_H
@@ -0,0 +1,310 @@
+#ifndef REWARD_TERM_H
+#define REWARD_TERM_H
+
+#include <omnetpp.h>
+#include <map>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <exception>
+#include "units.h"
+#include "signal_compiler.h"
+
+using namespace omnetpp;
+using namespace std;
+
+// Max number of symbols a reward term signal can bind to slots
+#define MAX_SIGNAL_SYMBOLS 8
+
+// Relative tolerance of the check of a compiled signal against the OMNeT++ evaluator
+#define SIGNAL_COMPILE_TOLERANCE 1e-9
+
+/**
+ * Normalizer is an abstract class that defines a method to normalize a value.
+ *
+ * Normalization is the process of scaling and centering variables.
+ * This can be useful when the variables have different units or scales.
+ *
+ * For example, if we have two variables, one in the range [0, 100] and the other
+ * in the range [0, 1000], the second variable will have a greater impact on the
+ * computation of the reward.
+ *
+ * Normalization can be used to scale the variables to the same range, so that
+ * they have the same impact on the computation of the reward.
+*/
+class Normalizer {
+
+  public:
+    virtual double normalize(double value) { return value; };
+    virtual ~Normalizer() {};
+};
+
+/**
+ * Restricts values from range [min, max] to [a, b]
+ * https://en.m.wikipedia.org/wiki/Feature_scaling#Rescaling_(min-max_normalization)
+ *
+ * For example, if we want to transform values in percentages:
+ *
+ * Normalizer *normalizer = new MinMaxNormalizer(0, max, 0, 1);
+ * double percentage = normalizer->normalize(value) * 100;
+*/
+class MinMaxNormalizer : public Normalizer {
+
+  private:
+    double min;
+    double max;
+    double a;
+    double b;
+
+  public:
+    MinMaxNormalizer(double min, double max) : MinMaxNormalizer(min, max, -1, 0) {}
+    MinMaxNormalizer(double min, double max, double a, double b)
+     : min(min), max(max), a(a), b(b) {}
+
+    double normalize(double value) override {
+      if (max == min) return 0;
+      return ((value - min) * (b - a)) / (max - min);
+    }
+
+    /**
+     * Changes the source range in place, so that a normalizer can be reused
+     * when the range of the values changes.
+    */
+    MinMaxNormalizer *setRange(double min, double max) {
+      this->min = min;
+      this->max = max;
+      return this;
+    }
+};
+
+class RewardTerm;
+
+/**
+ * Resolves the symbols of a reward term signal by reading them from the slots
+ * of the reward term.
+ * Slots are updated in place, so the resolver is installed only once for the
+ * whole life of the term.
+*/
+class SlotResolver : public cDynamicExpression::ResolverBase {
+  protected:
+    const RewardTerm *term;
+
+  public:
+    SlotResolver(const RewardTerm *term) : term(term) {}
+
+    virtual IResolver *dup() const override {
+      return new SlotResolver(term);
+    }
+
+    virtual cValue readVariable(cExpression::Context *context, const char *name) override;
+};
+
+/**
+ * Reward can be computed as a combination of different terms.
+ * Each term comes with a signal along with its weight.
+ *
+ * The signal is a function of a measured quantity which is informative about the
+ * agent perfomance (e.g. energy consumption, queue occupancy, etc.).
+ *
+ * The weight is a scalar that determines the importance of the corresponding term in
+ * the reward computation.
+ *
+ * Since signals are dynamic expressions (specified in .ini file), their symbols must
+ * be bound to actual values at runtime before computing the term value.
+ * Symbols can be bound either all at once with bind_symbols(), or to slots with
+ * bind_slot(). Slots are meant for terms that are computed many times: they are
+ * bound once and then updated in place with set_slot(), without allocating
+ * anything.
+ *
+ * Once all the slots are bound, the signal can be compiled with compile(), so that
+ * it's evaluated by a SignalProgram over the slot values instead of the OMNeT++
+ * expression evaluator. Signals that cannot be compiled keep being interpreted.
+*/
+class RewardTerm {
+
+  friend class SlotResolver;
+
+protected:
+  reward_t weight;
+  cOwnedDynamicExpression *signal;
+  Normalizer *normalizer;
+
+  bool cached = false;
+  reward_t cached_value;
+
+  const char *slot_names[MAX_SIGNAL_SYMBOLS];
+  double slot_values[MAX_SIGNAL_SYMBOLS];
+  int num_slots = 0;
+
+  SignalProgram program;
+  bool compiled = false;
+
+  /**
+   * Evaluates both the compiled and the interpreted signal at some probe slot
+   * values and checks they agree. Slot values are restored afterwards.
+  */
+  bool verify_program(string &error){
+    double saved_values[MAX_SIGNAL_SYMBOLS];
+    double interpreted;
+    double native;
+    bool agree = true;
+
+    memcpy(saved_values, slot_values, sizeof(slot_values));
+    for (int probe = 0; probe < 3 && agree; probe ++){
+      for (int i = 0; i < num_slots; i ++){
+        slot_values[i] = 0.5 + 1.25 * i + 3.5 * probe;
+      }
+      try {
+        interpreted = signal->doubleValue();
+      } catch (exception &e) {
+        error = string("the evaluator failed on probe values: ") + e.what();
+        agree = false;
+        break;
+      }
+      native = program.evaluate(slot_values);
+      if (fabs(native - interpreted) > SIGNAL_COMPILE_TOLERANCE * (1 + fabs(interpreted))){
+        error = "compiled and interpreted signal disagree";
+        agree = false;
+      }
+    }
+    memcpy(slot_values, saved_values, sizeof(slot_values));
+
+    return agree;
+  }
+
+public:
+  RewardTerm(reward_t weight, cOwnedDynamicExpression *signal)
+   : weight(weight), signal(signal->dup()) {
+    normalizer = new Normalizer();
+   }
+  RewardTerm(cValueMap *reward_term_map)
+   : RewardTerm(reward_term_map->get("weight").doubleValue(),
+    (cOwnedDynamicExpression *)reward_term_map->get("signal").objectValue()) {}
+  RewardTerm(cValueMap *reward_term_models, const char *reward_term_model_name)
+   : RewardTerm((cValueMap *) reward_term_models->get(reward_term_model_name)
+    .objectValue()) {}
+
+  ~RewardTerm(){
+    delete signal;
+    delete normalizer;
+  }
+
+  reward_t getWeight() const {
+    return weight;
+  }
+
+  cOwnedDynamicExpression* getSignal() const {
+    return signal;
+  }
+
+  RewardTerm *setWeight(reward_t weight) {
+    this->weight = weight;
+    return this;
+  }
+
+  RewardTerm *setNormalizer(Normalizer *normalizer) {
+    delete this->normalizer;
+    this->normalizer = normalizer;
+    return this;
+  }
+
+  RewardTerm *bind_symbols(map<string, cValue> symbols){
+    // resolver is owned by the dynamic expression, no need to delete it
+    // before setting a new one
+    compiled = false;
+    signal->setResolver(new cDynamicExpression::SymbolTable(symbols));
+    return this;
+  }
+
+  /**
+   * Binds a symbol of the signal to a slot of this term and returns the slot
+   * index. The slot value can be later updated with set_slot().
+   * The symbol name must outlive the term.
+  */
+  int bind_slot(const char *symbol){
+    if (num_slots == MAX_SIGNAL_SYMBOLS)
+      throw cRuntimeError("Cannot bind symbol %s: too many symbols", symbol);
+
+    // the slot resolver replaces any symbol table previously bound
+    if (num_slots == 0)
+      signal->setResolver(new SlotResolver(this));
+
+    // a program compiled before this binding would not know the new slot
+    compiled = false;
+    slot_names[num_slots] = symbol;
+    slot_values[num_slots] = 0;
+    return num_slots++;
+  }
+
+  RewardTerm *set_slot(int slot, double value){
+    slot_values[slot] = value;
+    return this;
+  }
+
+  /**
+   * Compiles the signal over the slots bound so far.
+   * Returns whether the signal is compiled; when it's not, the reason is
+   * written to error and the signal keeps being interpreted.
+  */
+  bool compile(string &error){
+    compiled = false;
+    if (num_slots == 0){
+      error = "no symbol is bound to a slot";
+      return false;
+    }
+    if (!compile_signal(signal->str().c_str(), slot_names, num_slots, program, error))
+      return false;
+    if (!verify_program(error)){
+      program.clear();
+      return false;
+    }
+    compiled = true;
+    return true;
+  }
+
+  /**
+   * Goes back to interpreting the signal.
+  */
+  void decompile(){
+    compiled = false;
+    program.clear();
+  }
+
+  bool isCompiled() const {
+    return compiled;
+  }
+
+  reward_t compute(bool use_cache = true) {
+
+    reward_t normalized_value;
+
+    if (!use_cache || !cached){
+      if (compiled){
+        normalized_value = normalizer->normalize(program.evaluate(slot_values));
+      } else {
+        if (signal->getResolver() == nullptr)
+          throw cRuntimeError("Signal resolver is not set. Call bind_symbols() first.");
+        normalized_value = normalizer->normalize(signal->doubleValue());
+      }
+      cached_value = weight * normalized_value;
+    }
+
+    return cached_value;
+  }
+
+  void invalidate_cache(){
+    cached = false;
+  }
+
+};
+
+inline cValue SlotResolver::readVariable(cExpression::Context *context, const char *name)
+{
+  for (int i = 0; i < term->num_slots; i ++){
+    if (strcmp(term->slot_names[i], name) == 0)
+      return cValue(term->slot_values[i]);
+  }
+  throw cRuntimeError("Unknown symbol %s in reward term signal", name);
+}
+
+#endif // REWARD_TERM_H
@@ -0,0 +1,288 @@
+#include "signal_compiler.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+struct SignalFunction {
+  const char *name;
+  int num_args;
+  double (*fn1)(double);
+  double (*fn2)(double, double);
+};
+
+static double signal_fabs(double x) { return fabs(x); }
+static double signal_sqrt(double x) { return sqrt(x); }
+static double signal_exp(double x) { return exp(x); }
+static double signal_log(double x) { return log(x); }
+static double signal_pow(double x, double y) { return pow(x, y); }
+static double signal_fmin(double x, double y) { return fmin(x, y); }
+static double signal_fmax(double x, double y) { return fmax(x, y); }
+
+static const SignalFunction signal_functions[] = {
+  {"fabs", 1, signal_fabs, nullptr},
+  {"sqrt", 1, signal_sqrt, nullptr},
+  {"exp", 1, signal_exp, nullptr},
+  {"log", 1, signal_log, nullptr},
+  {"pow", 2, nullptr, signal_pow},
+  {"fmin", 2, nullptr, signal_fmin},
+  {"fmax", 2, nullptr, signal_fmax},
+};
+
+/**
+ * Recursive descent parser of signal expressions, emitting the program code
+ * in postfix order:
+ *
+ *  expr    := term (('+' | '-') term)*
+ *  term    := unary (('*' | '/') unary)*
+ *  unary   := ('-' | '+') unary | power
+ *  power   := primary ('^' unary)?
+ *  primary := number | symbol | function '(' expr (',' expr)* ')' | '(' expr ')'
+*/
+class SignalParser {
+
+  protected:
+    const char *pos;
+    const char *const *slot_names;
+    int num_slots;
+    SignalProgram &program;
+    string &error;
+    int depth = 0;
+
+    void skip_spaces() {
+      while (isspace((unsigned char) *pos))
+        pos++;
+    }
+
+    bool accept(char c) {
+      skip_spaces();
+      if (*pos != c)
+        return false;
+      pos++;
+      return true;
+    }
+
+    bool fail(const string &reason) {
+      if (error.empty())
+        error = reason;
+      return false;
+    }
+
+    bool emit(SignalOp op, int pushed) {
+      SignalInstr instr = {op, 0, 0, nullptr, nullptr};
+
+      program.code.push_back(instr);
+      depth += pushed;
+      if (depth > SIGNAL_MAX_STACK)
+        return fail("expression too deep");
+      if (depth > program.stack_depth)
+        program.stack_depth = depth;
+      return true;
+    }
+
+    bool parse_expr() {
+      if (!parse_term())
+        return false;
+      while (true){
+        if (accept('+')){
+          if (!parse_term() || !emit(SIGNAL_ADD, -1))
+            return false;
+        } else if (accept('-')){
+          if (!parse_term() || !emit(SIGNAL_SUB, -1))
+            return false;
+        } else {
+          return true;
+        }
+      }
+    }
+
+    bool parse_term() {
+      if (!parse_unary())
+        return false;
+      while (true){
+        if (accept('*')){
+          if (!parse_unary() || !emit(SIGNAL_MUL, -1))
+            return false;
+        } else if (accept('/')){
+          if (!parse_unary() || !emit(SIGNAL_DIV, -1))
+            return false;
+        } else {
+          return true;
+        }
+      }
+    }
+
+    bool parse_unary() {
+      if (accept('-'))
+        return parse_unary() && emit(SIGNAL_NEG, 0);
+      if (accept('+'))
+        return parse_unary();
+      return parse_power();
+    }
+
+    bool parse_power() {
+      if (!parse_primary())
+        return false;
+      if (accept('^'))
+        return parse_unary() && emit(SIGNAL_POW, -1);
+      return true;
+    }
+
+    bool parse_number() {
+      char *end;
+      double value = strtod(pos, &end);
+
+      if (end == pos)
+        return fail("invalid number");
+      pos = end;
+      // a unit or any other suffix is not supported
+      if (isalpha((unsigned char) *pos) || *pos == '_')
+        return fail("numbers with units are not supported");
+      if (!emit(SIGNAL_CONST, 1))
+        return false;
+      program.code.back().value = value;
+      return true;
+    }
+
+    bool parse_call(const string &name) {
+      int num_args = 0;
+
+      for (const SignalFunction &function : signal_functions){
+        if (name != function.name)
+          continue;
+        if (!accept(')')){
+          do {
+            if (!parse_expr())
+              return false;
+            num_args++;
+          } while (accept(','));
+          if (!accept(')'))
+            return fail("missing ) after function arguments");
+        }
+        if (num_args != function.num_args)
+          return fail("wrong number of arguments to " + name);
+        if (!emit(num_args == 1 ? SIGNAL_CALL1 : SIGNAL_CALL2, 1 - num_args))
+          return false;
+        program.code.back().fn1 = function.fn1;
+        program.code.back().fn2 = function.fn2;
+        return true;
+      }
+      return fail("unsupported function " + name);
+    }
+
+    bool parse_symbol() {
+      const char *start = pos;
+      string name;
+
+      while (isalnum((unsigned char) *pos) || *pos == '_')
+        pos++;
+      name.assign(start, pos - start);
+
+      if (accept('('))
+        return parse_call(name);
+
+      for (int i = 0; i < num_slots; i ++){
+        if (name == slot_names[i]){
+          if (!emit(SIGNAL_SLOT, 1))
+            return false;
+          program.code.back().slot = i;
+          return true;
+        }
+      }
+      return fail("symbol " + name + " is not bound to a slot");
+    }
+
+    bool parse_primary() {
+      skip_spaces();
+      if (accept('(')){
+        if (!parse_expr())
+          return false;
+        if (!accept(')'))
+          return fail("missing )");
+        return true;
+      }
+      if (isdigit((unsigned char) *pos) || *pos == '.')
+        return parse_number();
+      if (isalpha((unsigned char) *pos) || *pos == '_')
+        return parse_symbol();
+      return fail(string("unsupported token at ") + pos);
+    }
+
+  public:
+    SignalParser(const char *text, const char *const *slot_names, int num_slots,
+     SignalProgram &program, string &error)
+     : pos(text), slot_names(slot_names), num_slots(num_slots), program(program),
+     error(error) {}
+
+    bool parse() {
+      if (!parse_expr())
+        return false;
+      skip_spaces();
+      if (*pos != '\0')
+        return fail(string("unsupported token at ") + pos);
+      return true;
+    }
+};
+
+double SignalProgram::evaluate(const double *slots) const
+{
+    double stack[SIGNAL_MAX_STACK];
+    int top = -1;
+
+    for (const SignalInstr &instr : code){
+        switch (instr.op){
+            case SIGNAL_CONST:
+                stack[++top] = instr.value;
+                break;
+            case SIGNAL_SLOT:
+                stack[++top] = slots[instr.slot];
+                break;
+            case SIGNAL_NEG:
+                stack[top] = -stack[top];
+                break;
+            case SIGNAL_ADD:
+                top--;
+                stack[top] = stack[top] + stack[top + 1];
+                break;
+            case SIGNAL_SUB:
+                top--;
+                stack[top] = stack[top] - stack[top + 1];
+                break;
+            case SIGNAL_MUL:
+                top--;
+                stack[top] = stack[top] * stack[top + 1];
+                break;
+            case SIGNAL_DIV:
+                top--;
+                stack[top] = stack[top] / stack[top + 1];
+                break;
+            case SIGNAL_POW:
+                top--;
+                stack[top] = pow(stack[top], stack[top + 1]);
+                break;
+            case SIGNAL_CALL1:
+                stack[top] = instr.fn1(stack[top]);
+                break;
+            case SIGNAL_CALL2:
+                top--;
+                stack[top] = instr.fn2(stack[top], stack[top + 1]);
+                break;
+        }
+    }
+
+    return stack[top];
+}
+
+bool compile_signal(const char *text, const char *const *slot_names, int num_slots,
+ SignalProgram &program, string &error)
+{
+    SignalParser parser(text, slot_names, num_slots, program, error);
+
+    program.clear();
+    error.clear();
+    if (!parser.parse()){
+        program.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef SIGNAL_COMPILER_H
+#define SIGNAL_COMPILER_H
+
+#include <vector>
+#include <string>
+
+using namespace std;
+
+// Max depth of the evaluation stack of a compiled signal
+#define SIGNAL_MAX_STACK 32
+
+enum SignalOp {
+  SIGNAL_CONST,
+  SIGNAL_SLOT,
+  SIGNAL_NEG,
+  SIGNAL_ADD,
+  SIGNAL_SUB,
+  SIGNAL_MUL,
+  SIGNAL_DIV,
+  SIGNAL_POW,
+  SIGNAL_CALL1,
+  SIGNAL_CALL2
+};
+
+struct SignalInstr {
+  SignalOp op;
+  // operand of SIGNAL_CONST
+  double value;
+  // operand of SIGNAL_SLOT
+  int slot;
+  // operands of SIGNAL_CALL1 and SIGNAL_CALL2
+  double (*fn1)(double);
+  double (*fn2)(double, double);
+};
+
+/**
+ * Flat stack bytecode of a reward term signal.
+ *
+ * Symbols of the signal are compiled to slot indexes, so evaluating the program
+ * only reads the slot values, with no name lookup and no allocation.
+*/
+class SignalProgram {
+
+  protected:
+    vector<SignalInstr> code;
+    int stack_depth = 0;
+
+    friend class SignalParser;
+
+  public:
+    bool empty() const {
+      return code.empty();
+    }
+
+    size_t size() const {
+      return code.size();
+    }
+
+    void clear() {
+      code.clear();
+      stack_depth = 0;
+    }
+
+    double evaluate(const double *slots) const;
+};
+
+/**
+ * Compiles the text of a signal expression to a SignalProgram.
+ *
+ * Supported constructs are numeric literals, symbols listed in slot_names,
+ * unary +/-, binary + - * / ^, parentheses and a few math functions
+ * (fabs, sqrt, exp, log, pow, fmin, fmax). Anything else makes the compilation
+ * fail: then false is returned, the reason is written to error and the caller
+ * is expected to keep evaluating the signal with the OMNeT++ evaluator.
+*/
+bool compile_signal(const char *text, const char *const *slot_names, int num_slots,
+ SignalProgram &program, string &error);
+
+#endif // SIGNAL_COMPILER_H
@@ -16,6 +16,7 @@
 #include "src_controller.h"
 #include "SimulationMsg_m.h"
 #include "DataMsg_m.h"
+#include "message_pool.h"
 #include <cmath>
 
 Define_Module(SrcController);
@@ -24,6 +25,8 @@ Define_Module(SrcController);
 void SrcController::initialize()
 {
     message_count = 0;
+    destination_rng = par("destination_rng").intValue();
+    send_timer = new cMessage("send_timer");
     //Send message to node itself cause can't enter loop in initialize
     schedule_data();
 
@@ -32,9 +35,10 @@ void SrcController::initialize()
 void SrcController::handleMessage(cMessage *msg)
 {
     // Handle incoming messages
-    if (msg->isSelfMessage()) {
+    if (msg == send_timer) {
         sendData();
         schedule_data();
+        return;
     }
     delete msg;
     
@@ -43,14 +47,16 @@ void SrcController::handleMessage(cMessage *msg)
 
 int SrcController::randomIntGenerator(int min, int max)
 {
-    int res = min + rand() % (max - min + 1);
-    return res;
+    // no draw is needed when there is a single choice
+    if (min == max)
+        return min;
+    return intuniform(min, max, destination_rng);
 }
 
 void SrcController::schedule_data()
 {
     simtime_t delay = par("send_interval").doubleValue();
-    scheduleAt(simTime()+delay, new cMessage());
+    scheduleAt(simTime()+delay, send_timer);
 }
 
 
@@ -59,10 +65,15 @@ void SrcController::sendData()
 {   
     int n = gateSize("network_port");
     int neigh = randomIntGenerator(0, n-1);
-    DataMsg *data = new DataMsg();
+    DataMsg *data = acquire_msg<DataMsg>();
     float data_size = ceil(par("pkt_size").doubleValue());
     EV_DEBUG << "Sending data of size " << data_size << " to node " << neigh << "\n";
     data->setData(data_size);
     message_count++;
     send(data, "network_port", neigh);
 }
+
+SrcController::~SrcController()
+{
+    cancelAndDelete(send_timer);
+}
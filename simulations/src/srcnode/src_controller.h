@@ -25,12 +25,24 @@ class SrcController : public cSimpleModule
 {
   protected:
     int message_count;
+    // self message of the next packet, reused for every packet
+    cMessage *send_timer = nullptr;
+
+    /**
+     * Module parameters:
+    */
+    int destination_rng;
+
+    /* Module parameters (END)*/
   protected:
     virtual void initialize() override;
     virtual void handleMessage(cMessage *msg) override;
     void sendData();
     int randomIntGenerator(int min, int max);
     void schedule_data();
+
+  public:
+    virtual ~SrcController();
 };
 
 #endif
@@ -3,11 +3,11 @@
 
 #include <omnetpp.h>
 #include <cmath>
+#include <cstdlib>
 
 using namespace omnetpp;
 using namespace std;
 
-// TODO: find a way to move this in .ini file
 // Choose negative powers of 2 to improve perfomance
 #define EWMA_ALPHA_DEFAULT 0.25
 
@@ -20,6 +20,8 @@ using namespace std;
  * average that gives more weight to recent values
  * according to the alpha parameter.
  * https://en.wikipedia.org/wiki/Moving_average#Exponential_moving_average 
+ *
+ * Alpha can be set with the ewmaAlpha attribute of the statistic.
 */
 class EWMAFilter : public cNumericResultFilter
 {
@@ -27,6 +29,16 @@ class EWMAFilter : public cNumericResultFilter
     double alpha;
     double average;
 
+    virtual void init(Context *ctx) override
+    {
+      const char *alpha_attr = ctx->attrsProperty != nullptr ?
+       ctx->attrsProperty->getValue("ewmaAlpha") : nullptr;
+
+      cNumericResultFilter::init(ctx);
+      if (alpha_attr != nullptr && *alpha_attr != '\0')
+        alpha = atof(alpha_attr);
+    }
+
     virtual bool process(simtime_t& t, double& value, cObject *details)
     {
       swallow_if_nan(value);
@@ -106,8 +118,45 @@ Register_ResultFilter("sumPerSimtime", SumPerSimtimeFilter);
  * 
  * Must be called from a cComponent object.
 */
-#define measure_quantity(_name, _value) emit(registerSignal(_name), _value)
-#define measure_quantity_by_sid(_sid, _value) emit(_sid, _value)
+#define measure_quantity(_name, _value) measure_quantity_by_sid(registerSignal(_name), _value)
+/**
+ * The value is not even computed if nobody listens to the signal.
+*/
+#define measure_quantity_by_sid(_sid, _value)\
+  (mayHaveListeners(_sid) ? emit(_sid, _value) : (void) 0)
+
+/**
+ * Registry of the quantities measured by a module.
+ *
+ * Quantities are declared once in a X-macro list, and the signals are
+ * resolved when the module is initialized, so measuring a quantity is an
+ * indexed emit instead of a lookup by name in the signal table:
+ *
+ *   #define CONTROLLER_QUANTITIES(X) X(reward) X(action)
+ *   class Controller : public cSimpleModule {
+ *       declare_quantities(CONTROLLER_QUANTITIES)
+ *       ...
+ *   };
+ *
+ *   init_quantity_signals();                  // in initialize()
+ *   measure_declared_quantity(reward, value); // anywhere else
+ *
+ * Measuring a quantity missing from the list is a compile error.
+ * Must be used in a cComponent class.
+*/
+#define _quantity_enum_entry(_name) _name##_quantity,
+#define _quantity_name_entry(_name) #_name,
+#define declare_quantities(_quantities)\
+  enum Quantity { _quantities(_quantity_enum_entry) NUM_QUANTITIES };\
+  static constexpr const char *quantity_names[NUM_QUANTITIES] = { _quantities(_quantity_name_entry) };\
+  simsignal_t quantity_signals[NUM_QUANTITIES] = {};
+#define init_quantity_signals()\
+{\
+  for (int _i = 0; _i < NUM_QUANTITIES; _i ++)\
+    quantity_signals[_i] = registerSignal(quantity_names[_i]);\
+}
+#define measure_declared_quantity(_name, _value)\
+  measure_quantity_by_sid(quantity_signals[_name##_quantity], _value)
 
 #define register_statistic_template(_quantity_name, _template_name)\
 {\
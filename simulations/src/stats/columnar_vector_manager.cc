@@ -0,0 +1,234 @@
+#include "columnar_vector_manager.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+Register_Class(ColumnarOutputVectorManager);
+
+Register_PerRunConfigOption(CFGID_COLUMNAR_VECTOR_DIR, "columnar-vector-dir", CFG_FILENAME,
+ "${resultdir}/${configname}-${iterationvarsf}#${repetition}.vecc",
+ "Directory of the chunk files written by ColumnarOutputVectorManager.");
+Register_PerRunConfigOptionU(CFGID_COLUMNAR_VECTOR_CHUNK_SIZE, "columnar-vector-chunk-size", "B",
+ "64MiB", "Chunk files of ColumnarOutputVectorManager are rotated when they exceed this size.");
+Register_PerRunConfigOption(CFGID_COLUMNAR_VECTOR_BLOCK_LENGTH, "columnar-vector-block-length", CFG_INT,
+ "4096", "Samples of a vector buffered by ColumnarOutputVectorManager before being encoded.");
+
+namespace fs = std::filesystem;
+
+ColumnarOutputVectorManager::~ColumnarOutputVectorManager()
+{
+    endRun();
+    for (Vector *vec : vectors){
+        delete vec;
+    }
+}
+
+bool ColumnarOutputVectorManager::vector_recording_enabled(const char *object_name)
+{
+    const char *recording = getEnvir()->getConfig()->getPerObjectConfigValue(object_name,
+     "vector-recording");
+
+    return recording == nullptr || strcmp(recording, "false") != 0;
+}
+
+string ColumnarOutputVectorManager::chunk_name(int num, bool part) const
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "chunk-%06d.bin%s", num, part ? ".part" : "");
+    return dir_name + "/" + name;
+}
+
+void ColumnarOutputVectorManager::startRun()
+{
+    cConfiguration *config = getEnvir()->getConfig();
+
+    start_run(config->getAsFilename(CFGID_COLUMNAR_VECTOR_DIR),
+     (size_t) config->getAsDouble(CFGID_COLUMNAR_VECTOR_CHUNK_SIZE),
+     max((long) config->getAsInt(CFGID_COLUMNAR_VECTOR_BLOCK_LENGTH), 1L));
+}
+
+void ColumnarOutputVectorManager::start_run(const string &dir_name, size_t max_chunk_size,
+ size_t block_length)
+{
+    error_code error;
+
+    endRun();
+
+    this->dir_name = dir_name;
+    this->max_chunk_size = max_chunk_size;
+    this->block_length = block_length;
+
+    // vectors left from the previous run keep their handles, ids restart
+    vectors.erase(remove(vectors.begin(), vectors.end(), nullptr), vectors.end());
+    for (size_t i = 0; i < vectors.size(); i ++){
+        vectors[i]->slot = i;
+    }
+    next_id = 0;
+
+    fs::create_directories(dir_name, error);
+    if (error)
+        throw cRuntimeError("ColumnarOutputVectorManager: cannot create directory %s: %s",
+         dir_name.c_str(), error.message().c_str());
+    // chunks of a previous run must not be mixed with the new ones
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir_name, error)){
+        if (entry.path().filename().string().rfind("chunk-", 0) == 0)
+            fs::remove(entry.path(), error);
+    }
+
+    index_file = fopen((dir_name + "/index.tsv").c_str(), "w");
+    if (index_file == nullptr)
+        throw cRuntimeError("ColumnarOutputVectorManager: cannot open %s/index.tsv: %s",
+         dir_name.c_str(), strerror(errno));
+    fprintf(index_file, "version\t%d\n", VECTOR_CHUNK_VERSION);
+
+    chunk_num = 0;
+    open_chunk();
+}
+
+void ColumnarOutputVectorManager::endRun()
+{
+    // recorders deregister their vectors after the end of the run, when the
+    // network is deleted, so vectors are only flushed and disabled here
+    for (Vector *vec : vectors){
+        if (vec == nullptr)
+            continue;
+        if (vec->enabled && chunk_file != nullptr)
+            write_block(vec);
+        vec->enabled = false;
+    }
+
+    close_chunk();
+    if (index_file != nullptr){
+        fclose(index_file);
+        index_file = nullptr;
+    }
+}
+
+void ColumnarOutputVectorManager::open_chunk()
+{
+    VectorChunkHeader header = {};
+
+    chunk_file = fopen(chunk_name(chunk_num, true).c_str(), "wb");
+    if (chunk_file == nullptr)
+        throw cRuntimeError("ColumnarOutputVectorManager: cannot open %s: %s",
+         chunk_name(chunk_num, true).c_str(), strerror(errno));
+
+    header.magic = VECTOR_CHUNK_MAGIC;
+    header.version = VECTOR_CHUNK_VERSION;
+    header.time_scale_exp = SimTime::getScaleExp();
+    fwrite(&header, sizeof(header), 1, chunk_file);
+    chunk_size = sizeof(header);
+}
+
+void ColumnarOutputVectorManager::close_chunk()
+{
+    error_code error;
+
+    if (chunk_file == nullptr)
+        return;
+    fclose(chunk_file);
+    chunk_file = nullptr;
+    fs::rename(chunk_name(chunk_num, true), chunk_name(chunk_num, false), error);
+    chunk_num ++;
+}
+
+void ColumnarOutputVectorManager::write_block(Vector *vec)
+{
+    if (vec->times.empty())
+        return;
+
+    encoded.clear();
+    encode_vector_block(vec->id, vec->times.data(), vec->values.data(),
+     vec->times.size(), encoded);
+    vec->times.clear();
+    vec->values.clear();
+
+    if (fwrite(encoded.data(), 1, encoded.size(), chunk_file) != encoded.size())
+        throw cRuntimeError("ColumnarOutputVectorManager: cannot write %s",
+         chunk_name(chunk_num, true).c_str());
+    chunk_size += encoded.size();
+
+    if (chunk_size >= max_chunk_size){
+        close_chunk();
+        open_chunk();
+    }
+}
+
+void ColumnarOutputVectorManager::write_index_attribute(uint32_t id, const char *name,
+ const char *value)
+{
+    // tabs and newlines would break the index
+    string escaped = value;
+
+    for (char &c : escaped){
+        if (c == '\t' || c == '\n')
+            c = ' ';
+    }
+    fprintf(index_file, "attr\t%u\t%s\t%s\n", id, name, escaped.c_str());
+}
+
+void *ColumnarOutputVectorManager::registerVector(const char *modulename,
+ const char *vectorname, opp_string_map *attributes)
+{
+    Vector *vec = new Vector();
+    string object_name = string(modulename) + "." + vectorname;
+
+    vec->id = next_id ++;
+    vec->slot = vectors.size();
+    vec->enabled = vector_recording_enabled(object_name.c_str());
+    vectors.push_back(vec);
+
+    if (!vec->enabled || index_file == nullptr)
+        return vec;
+
+    vec->times.reserve(block_length);
+    vec->values.reserve(block_length);
+    fprintf(index_file, "vector\t%u\t%s\t%s\n", vec->id, modulename, vectorname);
+    if (attributes != nullptr){
+        for (auto &attribute : *attributes){
+            write_index_attribute(vec->id, attribute.first.c_str(), attribute.second.c_str());
+        }
+    }
+    // readers can find the vector as soon as its first chunk is complete
+    fflush(index_file);
+    return vec;
+}
+
+void ColumnarOutputVectorManager::deregisterVector(void *vechandle)
+{
+    Vector *vec = (Vector *) vechandle;
+
+    // ids are never reused within a run
+    if (vec->enabled && chunk_file != nullptr)
+        write_block(vec);
+    vectors[vec->slot] = nullptr;
+    delete vec;
+}
+
+bool ColumnarOutputVectorManager::record(void *vechandle, simtime_t t, double value)
+{
+    Vector *vec = (Vector *) vechandle;
+
+    if (!vec->enabled || chunk_file == nullptr)
+        return false;
+
+    vec->times.push_back(t.raw());
+    vec->values.push_back(value);
+    if (vec->times.size() >= block_length)
+        write_block(vec);
+    return true;
+}
+
+void ColumnarOutputVectorManager::flush()
+{
+    if (chunk_file == nullptr)
+        return;
+    for (Vector *vec : vectors){
+        if (vec != nullptr && vec->enabled)
+            write_block(vec);
+    }
+    fflush(chunk_file);
+    fflush(index_file);
+}
@@ -0,0 +1,102 @@
+#ifndef COLUMNAR_VECTOR_MANAGER_H
+#define COLUMNAR_VECTOR_MANAGER_H
+
+#include <omnetpp.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "vector_codec.h"
+
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * Output vector manager writing vectors in a columnar binary format instead
+ * of the text .vec file. Enable it with:
+ *
+ *   outputvectormanager-class = "ColumnarOutputVectorManager"
+ *
+ * Samples of each vector are buffered and encoded in blocks of
+ * columnar-vector-block-length samples (see vector_codec.h), appended to
+ * chunk files in the columnar-vector-dir directory:
+ * - index.tsv lists the vectors, their ids and attributes, and it is
+ *   appended as soon as a vector is registered;
+ * - chunk-NNNNNN.bin are the chunk files. The file being written has the
+ *   .part suffix and is renamed when it exceeds columnar-vector-chunk-size,
+ *   so complete chunks can be analysed while the simulation runs.
+ *
+ * Chunks can be read with tools/vecc_reader.
+ * Per vector vector-recording = false is honoured, recording intervals are
+ * not.
+*/
+class ColumnarOutputVectorManager : public cIOutputVectorManager
+{
+  protected:
+    struct Vector {
+      uint32_t id;
+      // position in vectors
+      size_t slot;
+      bool enabled;
+      vector<int64_t> times;
+      vector<double> values;
+    };
+
+    /**
+     * Registered vectors, a vector is freed when it is deregistered and its
+     * slot is set to nullptr. Vectors still registered at the end of a run
+     * stay valid but are disabled.
+    */
+    vector<Vector *> vectors;
+    uint32_t next_id = 0;
+    string dir_name;
+    FILE *index_file = nullptr;
+    FILE *chunk_file = nullptr;
+    int chunk_num = 0;
+    size_t chunk_size = 0;
+    // encoded blocks, reused by every write
+    vector<uint8_t> encoded;
+
+    /**
+     * Configuration:
+    */
+    size_t max_chunk_size;
+    size_t block_length;
+    /* Configuration (END)*/
+
+    /**
+     * Opens the index and the first chunk in dir_name, the configuration
+     * is read by startRun().
+    */
+    void start_run(const string &dir_name, size_t max_chunk_size, size_t block_length);
+    /**
+     * Returns whether vector-recording is enabled for the vector.
+    */
+    virtual bool vector_recording_enabled(const char *object_name);
+    string chunk_name(int num, bool part) const;
+    void open_chunk();
+    void close_chunk();
+    /**
+     * Encodes the buffered samples of the vector and appends them to the
+     * current chunk, rotating it if needed.
+    */
+    void write_block(Vector *vec);
+    void write_index_attribute(uint32_t id, const char *name, const char *value);
+
+  public:
+    virtual ~ColumnarOutputVectorManager();
+
+    virtual void startRun() override;
+    virtual void endRun() override;
+    virtual void *registerVector(const char *modulename, const char *vectorname,
+     opp_string_map *attributes = nullptr) override;
+    virtual void deregisterVector(void *vechandle) override;
+    virtual bool record(void *vechandle, simtime_t t, double value) override;
+    virtual const char *getFileName() const override {
+      return dir_name.c_str();
+    }
+    virtual void flush() override;
+};
+
+#endif // COLUMNAR_VECTOR_MANAGER_H
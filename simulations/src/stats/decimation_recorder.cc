@@ -0,0 +1,153 @@
+#include "decimation_recorder.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+Register_ResultRecorder("decimated", DecimationRecorder);
+
+void DecimationRecorder::init(Context *ctx)
+{
+    cNumericResultRecorder::init(ctx);
+
+    auto attributes = getStatisticAttributes();
+    auto mode_attr = attributes.find("decimationMode");
+    auto deadband_attr = attributes.find("decimationDeadband");
+    auto bucket_attr = attributes.find("decimationBucket");
+
+    if (mode_attr != attributes.end()){
+        if (strcmp(mode_attr->second.c_str(), "lttb") == 0)
+            lttb = true;
+        else if (strcmp(mode_attr->second.c_str(), "deadband") != 0)
+            throw cRuntimeError("decimated: unknown decimationMode %s of %s",
+             mode_attr->second.c_str(), getStatisticName());
+    }
+    if (deadband_attr != attributes.end())
+        deadband = atof(deadband_attr->second.c_str());
+    if (bucket_attr != attributes.end()){
+        if (atol(bucket_attr->second.c_str()) <= 0)
+            throw cRuntimeError("decimated: decimationBucket of %s must be positive",
+             getStatisticName());
+        bucket_size = atol(bucket_attr->second.c_str());
+    }
+
+    if (lttb){
+        bucket.reserve(bucket_size);
+        next_bucket.reserve(bucket_size);
+    }
+    output_vector = getEnvir()->registerOutputVector(getComponent()->getFullPath().c_str(),
+     getResultName().c_str());
+}
+
+DecimationRecorder::~DecimationRecorder()
+{
+    if (output_vector != nullptr)
+        getEnvir()->deregisterOutputVector(output_vector);
+}
+
+void DecimationRecorder::record(const Sample &sample)
+{
+    getEnvir()->recordInOutputVector(output_vector, sample.t, sample.value);
+    recorded ++;
+    last_recorded = sample;
+    has_recorded = true;
+}
+
+void DecimationRecorder::collect(simtime_t_cref t, double value, cObject *details)
+{
+    collected ++;
+    if (lttb)
+        collect_lttb({t, value});
+    else
+        collect_deadband({t, value});
+}
+
+void DecimationRecorder::collect_deadband(const Sample &sample)
+{
+    if (has_recorded && fabs(sample.value - last_recorded.value) <= deadband){
+        pending = sample;
+        has_pending = true;
+        return;
+    }
+    if (has_pending)
+        record(pending);
+    has_pending = false;
+    record(sample);
+}
+
+void DecimationRecorder::select_from_bucket(simtime_t_cref next_t, double next_value)
+{
+    double area;
+    double max_area = -1;
+    size_t selected = 0;
+    double dt_next = (next_t - last_recorded.t).dbl();
+    double dv_next = next_value - last_recorded.value;
+
+    // twice the area of the triangle (last recorded, sample, next point)
+    for (size_t i = 0; i < bucket.size(); i ++){
+        area = fabs((bucket[i].t - last_recorded.t).dbl() * dv_next
+         - dt_next * (bucket[i].value - last_recorded.value));
+        if (area > max_area){
+            max_area = area;
+            selected = i;
+        }
+    }
+    record(bucket[selected]);
+}
+
+void DecimationRecorder::collect_lttb(const Sample &sample)
+{
+    double mean_t = 0;
+    double mean_value = 0;
+
+    if (!has_recorded){
+        record(sample);
+        return;
+    }
+    if (bucket.size() < bucket_size){
+        bucket.push_back(sample);
+        return;
+    }
+    next_bucket.push_back(sample);
+    if (next_bucket.size() < bucket_size)
+        return;
+
+    for (const Sample &next : next_bucket){
+        mean_t += next.t.dbl();
+        mean_value += next.value;
+    }
+    select_from_bucket(mean_t / next_bucket.size(), mean_value / next_bucket.size());
+    bucket.swap(next_bucket);
+    next_bucket.clear();
+}
+
+void DecimationRecorder::finish(cResultFilter *prev)
+{
+    opp_string_map attributes = getStatisticAttributes();
+    string name = string(getStatisticName()) + ":retention";
+    Sample last;
+
+    // the last values are flushed, so the vector ends where the signal does
+    if (lttb && !bucket.empty()){
+        last = next_bucket.empty() ? bucket.back() : next_bucket.back();
+        if (next_bucket.empty())
+            bucket.pop_back();
+        else
+            next_bucket.pop_back();
+        if (!bucket.empty())
+            select_from_bucket(last.t, last.value);
+        if (!next_bucket.empty()){
+            bucket.swap(next_bucket);
+            select_from_bucket(last.t, last.value);
+        }
+        record(last);
+    }
+    else if (!lttb && has_pending)
+        record(pending);
+    bucket.clear();
+    next_bucket.clear();
+    has_pending = false;
+
+    getEnvir()->recordScalar(getComponent(), name.c_str(),
+     collected > 0 ? (double) recorded / collected : 1.0, &attributes);
+}
@@ -0,0 +1,85 @@
+#ifndef DECIMATION_RECORDER_H
+#define DECIMATION_RECORDER_H
+
+#include <omnetpp.h>
+#include <cstddef>
+#include <vector>
+
+using namespace omnetpp;
+using namespace std;
+
+// default number of values of which lttb keeps one
+#define DECIMATION_BUCKET_DEFAULT 16
+
+/**
+ * Vector recorder that drops the values not needed to plot the vector.
+ * At the end of the simulation it records the retention ratio of the
+ * vector, i.e. recorded values / collected values, as a scalar.
+ *
+ * The following statistic attributes are supported:
+ * - decimationMode: "deadband" (the default) or "lttb";
+ * - decimationDeadband: in deadband mode, a value is recorded only if it
+ *   differs from the last recorded one by more than this, 0 by default,
+ *   i.e. only changes are recorded. The value preceding a recorded one is
+ *   recorded too, so steps keep their shape;
+ * - decimationBucket: in lttb mode, values are split in buckets of this
+ *   size and only the value of each bucket forming the largest triangle
+ *   with the previous recorded value and the mean of the next bucket is
+ *   recorded (Largest-Triangle-Three-Buckets). Memory is 2 buckets.
+ *
+ * The first and the last values are always recorded.
+ *
+ * Usage: @statistic[name](source=...; record=decimated; decimationMode=lttb; decimationBucket=32)
+*/
+class DecimationRecorder : public cNumericResultRecorder
+{
+  protected:
+    struct Sample {
+      simtime_t t;
+      double value;
+    };
+
+    bool lttb = false;
+    double deadband = 0;
+    size_t bucket_size = DECIMATION_BUCKET_DEFAULT;
+
+    void *output_vector = nullptr;
+    long collected = 0;
+    long recorded = 0;
+
+    /**
+     * Deadband state
+    */
+    bool has_recorded = false;
+    Sample last_recorded;
+    bool has_pending = false;
+    // last collected value, not recorded yet
+    Sample pending;
+    /* Deadband state (END)*/
+
+    /**
+     * LTTB state: the bucket the next recorded value is selected from, and
+     * the bucket after it.
+    */
+    vector<Sample> bucket;
+    vector<Sample> next_bucket;
+    /* LTTB state (END)*/
+
+    virtual void init(Context *ctx) override;
+    virtual void collect(simtime_t_cref t, double value, cObject *details) override;
+    virtual void finish(cResultFilter *prev) override;
+
+    void record(const Sample &sample);
+    void collect_deadband(const Sample &sample);
+    void collect_lttb(const Sample &sample);
+    /**
+     * Records the value of bucket forming the largest triangle with the last
+     * recorded value and the given point.
+    */
+    void select_from_bucket(simtime_t_cref next_t, double next_value);
+
+  public:
+    virtual ~DecimationRecorder();
+};
+
+#endif // DECIMATION_RECORDER_H
@@ -0,0 +1,114 @@
+#include "energy_ledger.h"
+#include <string>
+
+const char *EnergyLedger::vector_names[NUM_LEDGER_VECTORS] = {
+    "cumulative_energy_expense",
+    "cumulative_energy_potential_expense",
+    "cumulative_energy_consumption",
+    "ewma_energy_expense_per_mWh_over_time",
+    "ewma_energy_expense_per_second_over_time",
+    "ewma_energy_consumption_per_second_over_time",
+    "ewma_energy_saving_over_time",
+};
+
+EnergyLedger::EnergyLedger(cComponent *source, cComponent *owner, double ewma_alpha)
+{
+    string vector_name;
+
+    this->source = source;
+    this->owner = owner;
+    this->ewma_alpha = ewma_alpha;
+
+    signals[ENERGY_EXPENSE] = cComponent::registerSignal("energy_expense");
+    signals[ENERGY_CONSUMPTION] = cComponent::registerSignal("energy_consumption");
+    signals[ENERGY_POTENTIAL_EXPENSE] = cComponent::registerSignal("energy_potential_expense");
+    for (int i = 0; i < NUM_LEDGER_SIGNALS; i ++){
+        source->subscribe(signals[i], this);
+    }
+
+    for (int i = 0; i < NUM_LEDGER_VECTORS; i ++){
+        vector_name = string(vector_names[i]) + ":vector";
+        output_vectors[i] = getEnvir()->registerOutputVector(owner->getFullPath().c_str(),
+         vector_name.c_str());
+    }
+}
+
+EnergyLedger::~EnergyLedger()
+{
+    for (int i = 0; i < NUM_LEDGER_SIGNALS; i ++){
+        source->unsubscribe(signals[i], this);
+    }
+    for (int i = 0; i < NUM_LEDGER_VECTORS; i ++){
+        getEnvir()->deregisterOutputVector(output_vectors[i]);
+    }
+}
+
+void EnergyLedger::receiveSignal(cComponent *src, simsignal_t id, double value,
+ cObject *details)
+{
+    for (int i = 0; i < NUM_LEDGER_SIGNALS; i ++){
+        if (id != signals[i])
+            continue;
+        sums[i] += value;
+        received |= 1 << i;
+    }
+
+    if (received == (1 << NUM_LEDGER_SIGNALS) - 1){
+        received = 0;
+        update(simTime());
+    }
+}
+
+void EnergyLedger::record(simtime_t_cref t, LedgerVector vec, double value)
+{
+    getEnvir()->recordInOutputVector(output_vectors[vec], t, value);
+    last_values[vec] = value;
+    num_values[vec] ++;
+}
+
+void EnergyLedger::ewma(simtime_t_cref t, LedgerVector vec, double value)
+{
+    // same as EWMAFilter, the average starts from 0
+    record(t, vec, (1 - ewma_alpha) * last_values[vec] + ewma_alpha * value);
+}
+
+void EnergyLedger::update(simtime_t_cref t)
+{
+    double cost_per_mWh;
+
+    if (t < getSimulation()->getWarmupPeriod())
+        return;
+
+    record(t, CUMULATIVE_ENERGY_EXPENSE, sums[ENERGY_EXPENSE]);
+    record(t, CUMULATIVE_ENERGY_POTENTIAL_EXPENSE, sums[ENERGY_POTENTIAL_EXPENSE]);
+    record(t, CUMULATIVE_ENERGY_CONSUMPTION, sums[ENERGY_CONSUMPTION]);
+
+    if (sums[ENERGY_CONSUMPTION] != 0){
+        cost_per_mWh = sums[ENERGY_EXPENSE] / sums[ENERGY_CONSUMPTION];
+        cost_per_mWh_sum += cost_per_mWh;
+        cost_per_mWh_count ++;
+        ewma(t, EWMA_ENERGY_EXPENSE_PER_MWH, cost_per_mWh);
+    }
+    if (t > 0){
+        ewma(t, EWMA_ENERGY_EXPENSE_PER_SECOND, sums[ENERGY_EXPENSE] / t.dbl());
+        ewma(t, EWMA_ENERGY_CONSUMPTION_PER_SECOND, sums[ENERGY_CONSUMPTION] / t.dbl());
+    }
+    if (sums[ENERGY_POTENTIAL_EXPENSE] != 0)
+        ewma(t, EWMA_ENERGY_SAVING,
+         100 - sums[ENERGY_EXPENSE] / sums[ENERGY_POTENTIAL_EXPENSE] * 100);
+}
+
+void EnergyLedger::record_scalars()
+{
+    string name;
+
+    if (cost_per_mWh_count > 0)
+        owner->recordScalar("avg_cost_per_mWh:mean", cost_per_mWh_sum / cost_per_mWh_count);
+    for (int i = 0; i < NUM_LEDGER_VECTORS; i ++){
+        // as the last recorder, nothing is recorded without values
+        if (num_values[i] == 0)
+            continue;
+        name = string(vector_names[i]) + ":last";
+        owner->recordScalar(name.c_str(), last_values[i]);
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef ENERGY_LEDGER_H
+#define ENERGY_LEDGER_H
+
+#include <omnetpp.h>
+
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * Energy statistics of a node, computed in a single pass.
+ *
+ * Listens to the energy_expense, energy_consumption and
+ * energy_potential_expense signals of a module, which are emitted together
+ * at each action, keeps their aggregates and records the derived vectors and
+ * scalars as results of the owner component, with the same names the
+ * equivalent @statistic filter chains would use:
+ * - cumulative_energy_expense, cumulative_energy_potential_expense and
+ *   cumulative_energy_consumption: warmup(sum(x));
+ * - avg_cost_per_mWh: mean of warmup(sum(energy_expense)/sum(energy_consumption)),
+ *   as a scalar only;
+ * - ewma_energy_expense_per_mWh_over_time: ewma of the ratio above;
+ * - ewma_energy_expense_per_second_over_time and
+ *   ewma_energy_consumption_per_second_over_time: ewma(warmup(sumPerSimtime(x)));
+ * - ewma_energy_saving_over_time:
+ *   ewma(100 - warmup(sum(energy_expense)/sum(energy_potential_expense)) * 100).
+ * Vectors are recorded with the :vector suffix and their last values as
+ * :last scalars, which are not recorded for empty vectors. Sums include the
+ * values before the warm-up period, values are recorded only after it.
+*/
+class EnergyLedger : public cListener
+{
+  protected:
+    enum LedgerVector {
+      CUMULATIVE_ENERGY_EXPENSE,
+      CUMULATIVE_ENERGY_POTENTIAL_EXPENSE,
+      CUMULATIVE_ENERGY_CONSUMPTION,
+      EWMA_ENERGY_EXPENSE_PER_MWH,
+      EWMA_ENERGY_EXPENSE_PER_SECOND,
+      EWMA_ENERGY_CONSUMPTION_PER_SECOND,
+      EWMA_ENERGY_SAVING,
+      NUM_LEDGER_VECTORS
+    };
+    static const char *vector_names[NUM_LEDGER_VECTORS];
+
+    // enum LedgerSignal
+    enum {
+      ENERGY_EXPENSE,
+      ENERGY_CONSUMPTION,
+      ENERGY_POTENTIAL_EXPENSE,
+      NUM_LEDGER_SIGNALS
+    };
+
+    cComponent *source;
+    cComponent *owner;
+    simsignal_t signals[NUM_LEDGER_SIGNALS];
+    void *output_vectors[NUM_LEDGER_VECTORS] = {};
+
+    /**
+     * Aggregates, updated once all the signals of an action are received.
+    */
+    double sums[NUM_LEDGER_SIGNALS] = {};
+    // bitmask of the signals received since the last update
+    int received = 0;
+    double ewma_alpha;
+    double last_values[NUM_LEDGER_VECTORS] = {};
+    // values recorded in each vector
+    long num_values[NUM_LEDGER_VECTORS] = {};
+    double cost_per_mWh_sum = 0;
+    long cost_per_mWh_count = 0;
+    /* Aggregates (END)*/
+
+    void update(simtime_t_cref t);
+    void record(simtime_t_cref t, LedgerVector vec, double value);
+    void ewma(simtime_t_cref t, LedgerVector vec, double value);
+
+  public:
+    /**
+     * Subscribes to the signals of source, results are recorded as results
+     * of owner.
+    */
+    EnergyLedger(cComponent *source, cComponent *owner, double ewma_alpha);
+    virtual ~EnergyLedger();
+
+    virtual void receiveSignal(cComponent *src, simsignal_t id, double value,
+     cObject *details) override;
+
+    /**
+     * Records the scalars, must be called in the finish() of a module.
+    */
+    void record_scalars();
+};
+
+#endif // ENERGY_LEDGER_H
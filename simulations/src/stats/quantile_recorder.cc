@@ -0,0 +1,96 @@
+#include "quantile_recorder.h"
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+Register_ResultRecorder("quantiles", QuantileRecorder);
+
+const double QuantileRecorder::quantiles[NUM_RECORDED_QUANTILES] = {0.5, 0.9, 0.99, 0.999};
+const char *QuantileRecorder::quantile_names[NUM_RECORDED_QUANTILES] = {"p50", "p90", "p99", "p99.9"};
+
+void QuantileRecorder::init(Context *ctx)
+{
+    double accuracy = QUANTILE_SKETCH_ACCURACY;
+    string vector_name;
+
+    cNumericResultRecorder::init(ctx);
+
+    auto attributes = getStatisticAttributes();
+    auto accuracy_attr = attributes.find("quantileAccuracy");
+    auto interval_attr = attributes.find("quantileSnapshotInterval");
+
+    if (accuracy_attr != attributes.end()){
+        accuracy = atof(accuracy_attr->second.c_str());
+        if (accuracy <= 0 || accuracy >= 1)
+            throw cRuntimeError("quantiles: quantileAccuracy of %s must be in (0, 1)",
+             getStatisticName());
+    }
+    if (interval_attr != attributes.end())
+        snapshot_interval = SimTime::parse(interval_attr->second.c_str());
+
+    sketch = new QuantileSketch(accuracy);
+    if (snapshot_interval <= 0)
+        return;
+
+    interval_sketch = new QuantileSketch(accuracy);
+    next_snapshot = simTime() + snapshot_interval;
+    for (int i = 0; i < NUM_RECORDED_QUANTILES; i ++){
+        vector_name = string(getStatisticName()) + ":" + quantile_names[i];
+        snapshot_vectors[i] = getEnvir()->registerOutputVector(
+         getComponent()->getFullPath().c_str(), vector_name.c_str());
+    }
+}
+
+QuantileRecorder::~QuantileRecorder()
+{
+    for (int i = 0; i < NUM_RECORDED_QUANTILES; i ++){
+        if (snapshot_vectors[i] != nullptr)
+            getEnvir()->deregisterOutputVector(snapshot_vectors[i]);
+    }
+    delete sketch;
+    delete interval_sketch;
+}
+
+void QuantileRecorder::collect(simtime_t_cref t, double value, cObject *details)
+{
+    if (interval_sketch == nullptr){
+        sketch->insert(value);
+        return;
+    }
+
+    // intervals without values have no snapshot
+    if (t >= next_snapshot){
+        if (interval_sketch->getCount() > 0)
+            record_snapshot(next_snapshot);
+        next_snapshot += snapshot_interval * (floor((t - next_snapshot) / snapshot_interval) + 1);
+    }
+    interval_sketch->insert(value);
+}
+
+void QuantileRecorder::record_snapshot(simtime_t_cref t)
+{
+    for (int i = 0; i < NUM_RECORDED_QUANTILES; i ++){
+        getEnvir()->recordInOutputVector(snapshot_vectors[i], t,
+         interval_sketch->quantile(quantiles[i]));
+    }
+    sketch->merge(*interval_sketch);
+    interval_sketch->clear();
+}
+
+void QuantileRecorder::finish(cResultFilter *prev)
+{
+    opp_string_map attributes = getStatisticAttributes();
+    string name;
+
+    // the last interval is partial, it ends now
+    if (interval_sketch != nullptr && interval_sketch->getCount() > 0)
+        record_snapshot(simTime());
+
+    name = string(getStatisticName()) + ":count";
+    getEnvir()->recordScalar(getComponent(), name.c_str(), sketch->getCount(), &attributes);
+    for (int i = 0; i < NUM_RECORDED_QUANTILES; i ++){
+        name = string(getStatisticName()) + ":" + quantile_names[i];
+        getEnvir()->recordScalar(getComponent(), name.c_str(),
+         sketch->quantile(quantiles[i]), &attributes);
+    }
+}
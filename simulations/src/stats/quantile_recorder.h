@@ -0,0 +1,53 @@
+#ifndef QUANTILE_RECORDER_H
+#define QUANTILE_RECORDER_H
+
+#include <omnetpp.h>
+#include "quantile_sketch.h"
+
+using namespace omnetpp;
+using namespace std;
+
+#define NUM_RECORDED_QUANTILES 4
+
+/**
+ * Result recorder that keeps the values in a QuantileSketch instead of
+ * writing them, so memory and output size don't depend on the number of
+ * values. At the end of the simulation it records the p50, p90, p99 and
+ * p99.9 scalars of the statistic, along with the count of the values.
+ *
+ * The following statistic attributes are supported:
+ * - quantileAccuracy: relative accuracy of the sketch, 0.01 by default;
+ * - quantileSnapshotInterval: if set, the quantiles of the values collected
+ *   in each interval are written as vectors at the end of the interval.
+ *
+ * Usage: @statistic[name](source=...; record=quantiles; quantileSnapshotInterval=10s)
+*/
+class QuantileRecorder : public cNumericResultRecorder
+{
+  protected:
+    static const double quantiles[NUM_RECORDED_QUANTILES];
+    static const char *quantile_names[NUM_RECORDED_QUANTILES];
+
+    // values of the whole simulation
+    QuantileSketch *sketch = nullptr;
+    // values of the current snapshot interval, merged in sketch at its end
+    QuantileSketch *interval_sketch = nullptr;
+    simtime_t snapshot_interval = 0;
+    simtime_t next_snapshot = 0;
+    void *snapshot_vectors[NUM_RECORDED_QUANTILES] = {};
+
+    virtual void init(Context *ctx) override;
+    virtual void collect(simtime_t_cref t, double value, cObject *details) override;
+    virtual void finish(cResultFilter *prev) override;
+
+    /**
+     * Writes the quantiles of the current interval in the snapshot vectors
+     * at time t, the end of the interval, and starts a new interval.
+    */
+    void record_snapshot(simtime_t_cref t);
+
+  public:
+    virtual ~QuantileRecorder();
+};
+
+#endif // QUANTILE_RECORDER_H
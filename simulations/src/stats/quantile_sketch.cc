@@ -0,0 +1,135 @@
+#include "quantile_sketch.h"
+#include <algorithm>
+#include <cmath>
+
+QuantileSketch::QuantileSketch(double accuracy, size_t max_buckets)
+{
+    this->accuracy = accuracy;
+    this->max_buckets = max(max_buckets, (size_t) 1);
+    gamma = (1 + accuracy) / (1 - accuracy);
+    log_gamma = log(gamma);
+}
+
+int QuantileSketch::bucket_index(double value) const
+{
+    return (int) ceil(log(value) / log_gamma);
+}
+
+size_t QuantileSketch::reserve_bucket(int index)
+{
+    size_t grow;
+    size_t collapse;
+
+    if (buckets.empty()){
+        min_index = index;
+        buckets.push_back(0);
+        return 0;
+    }
+
+    if (index < min_index){
+        // values under a collapsed range go to its lowest bucket
+        if (buckets.size() == max_buckets)
+            return 0;
+        grow = min(max_buckets - buckets.size(), (size_t) (min_index - index));
+        buckets.insert(buckets.begin(), grow, 0);
+        min_index -= grow;
+        return index < min_index ? 0 : index - min_index;
+    }
+
+    if ((size_t) (index - min_index) >= buckets.size()){
+        buckets.resize(index - min_index + 1, 0);
+        if (buckets.size() > max_buckets){
+            // collapses the lowest buckets into the first one that is kept
+            collapse = buckets.size() - max_buckets;
+            for (size_t i = 0; i < collapse; i ++){
+                buckets[collapse] += buckets[i];
+            }
+            buckets.erase(buckets.begin(), buckets.begin() + collapse);
+            min_index += collapse;
+        }
+    }
+    return index - min_index;
+}
+
+void QuantileSketch::add_to_bucket(int index, uint64_t n)
+{
+    buckets[reserve_bucket(index)] += n;
+}
+
+void QuantileSketch::insert(double value)
+{
+    if (std::isnan(value))
+        return;
+
+    if (count == 0 || value < min_value)
+        min_value = value;
+    if (count == 0 || value > max_value)
+        max_value = value;
+    count ++;
+
+    if (value <= 0)
+        zero_count ++;
+    else
+        add_to_bucket(bucket_index(value), 1);
+}
+
+bool QuantileSketch::merge(const QuantileSketch &other)
+{
+    if (other.accuracy != accuracy)
+        return false;
+    if (other.count == 0)
+        return true;
+
+    if (count == 0 || other.min_value < min_value)
+        min_value = other.min_value;
+    if (count == 0 || other.max_value > max_value)
+        max_value = other.max_value;
+    count += other.count;
+    zero_count += other.zero_count;
+
+    // from the highest bucket, so the lowest ones are collapsed if needed
+    for (size_t i = other.buckets.size(); i > 0; i --){
+        if (other.buckets[i - 1] > 0)
+            add_to_bucket(other.min_index + (int) i - 1, other.buckets[i - 1]);
+    }
+    return true;
+}
+
+double QuantileSketch::quantile(double q) const
+{
+    double rank;
+    uint64_t seen;
+    double value;
+
+    if (count == 0)
+        return NAN;
+    if (q <= 0)
+        return min_value;
+    if (q >= 1)
+        return max_value;
+
+    rank = q * (count - 1);
+    seen = zero_count;
+    if (rank < seen)
+        return min(0.0, max_value);
+
+    for (size_t i = 0; i < buckets.size(); i ++){
+        seen += buckets[i];
+        if (rank < seen){
+            // middle of the bucket, relative to its bounds
+            value = 2 * pow(gamma, min_index + (int) i) / (gamma + 1);
+            return min(max(value, min_value), max_value);
+        }
+    }
+    return max_value;
+}
+
+void QuantileSketch::clear()
+{
+    buckets.clear();
+    min_index = 0;
+    zero_count = 0;
+    count = 0;
+    min_value = 0;
+    max_value = 0;
+}
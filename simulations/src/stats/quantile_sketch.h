@@ -0,0 +1,82 @@
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// default relative accuracy of the quantiles
+#define QUANTILE_SKETCH_ACCURACY 0.01
+// default maximum number of buckets, with 1% accuracy they cover 9 orders of
+// magnitude before the lowest buckets are collapsed
+#define QUANTILE_SKETCH_MAX_BUCKETS 2048
+
+/**
+ * Streaming quantile sketch with logarithmic buckets (DDSketch-like).
+ *
+ * A positive value v falls in bucket ceil(log(v) / log(gamma)), with
+ * gamma = (1 + accuracy) / (1 - accuracy), so every quantile is returned with
+ * at most the given relative error. Values <= 0 are counted apart.
+ * Memory is bounded: when the buckets would be more than max_buckets, the
+ * lowest ones are collapsed into one, losing accuracy only on the smallest
+ * values. Sketches with the same accuracy can be merged.
+*/
+class QuantileSketch {
+
+  protected:
+    double accuracy;
+    double gamma;
+    double log_gamma;
+    size_t max_buckets;
+
+    // buckets[i] counts the values in bucket min_index + i
+    vector<uint64_t> buckets;
+    int min_index = 0;
+    uint64_t zero_count = 0;
+    uint64_t count = 0;
+    double min_value = 0;
+    double max_value = 0;
+
+    int bucket_index(double value) const;
+    /**
+     * Makes room for bucket index, collapsing the lowest buckets if needed.
+     * Returns the position of index in buckets.
+    */
+    size_t reserve_bucket(int index);
+    void add_to_bucket(int index, uint64_t n);
+
+  public:
+    QuantileSketch(double accuracy = QUANTILE_SKETCH_ACCURACY,
+     size_t max_buckets = QUANTILE_SKETCH_MAX_BUCKETS);
+
+    void insert(double value);
+
+    /**
+     * Adds the values of another sketch with the same accuracy.
+     * Returns false if the accuracies differ.
+    */
+    bool merge(const QuantileSketch &other);
+
+    /**
+     * Returns the q-quantile, q in [0, 1], or NaN if the sketch is empty.
+    */
+    double quantile(double q) const;
+
+    uint64_t getCount() const {
+      return count;
+    }
+
+    double getAccuracy() const {
+      return accuracy;
+    }
+
+    size_t getNumBuckets() const {
+      return buckets.size();
+    }
+
+    void clear();
+};
+
+#endif // QUANTILE_SKETCH_H
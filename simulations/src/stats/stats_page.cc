@@ -0,0 +1,90 @@
+#include "stats_page.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+StatsPage *stats_page_create(const char *name, std::string &error)
+{
+    int fd;
+    void *addr;
+    StatsPage *page;
+
+    stats_page_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0){
+        error = std::string("shm_open ") + name + ": " + strerror(errno);
+        return nullptr;
+    }
+    if (ftruncate(fd, sizeof(StatsPage)) < 0){
+        error = std::string("ftruncate ") + name + ": " + strerror(errno);
+        close(fd);
+        return nullptr;
+    }
+
+    addr = mmap(nullptr, sizeof(StatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping keeps the page alive
+    close(fd);
+    if (addr == MAP_FAILED){
+        error = std::string("mmap ") + name + ": " + strerror(errno);
+        return nullptr;
+    }
+
+    page = (StatsPage *) addr;
+    memset((void *) page, 0, sizeof(StatsPage));
+    page->version = STATS_PAGE_VERSION;
+    page->max_nodes = STATS_PAGE_MAX_NODES;
+    page->max_queues = STATS_PAGE_MAX_QUEUES;
+    // readers check the magic number before anything else, so it's written last
+    std::atomic_thread_fence(std::memory_order_release);
+    page->magic = STATS_PAGE_MAGIC;
+
+    return page;
+}
+
+const StatsPage *stats_page_open(const char *name, std::string &error)
+{
+    int fd;
+    void *addr;
+    struct stat st;
+    const StatsPage *page;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0){
+        error = std::string("shm_open ") + name + ": " + strerror(errno);
+        return nullptr;
+    }
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(StatsPage)){
+        error = std::string(name) + " is not a stats page";
+        close(fd);
+        return nullptr;
+    }
+
+    addr = mmap(nullptr, sizeof(StatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED){
+        error = std::string("mmap ") + name + ": " + strerror(errno);
+        return nullptr;
+    }
+
+    page = (const StatsPage *) addr;
+    if (page->magic != STATS_PAGE_MAGIC || page->version != STATS_PAGE_VERSION){
+        error = std::string(name) + " is not a stats page of this version";
+        stats_page_close(page);
+        return nullptr;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return page;
+}
+
+void stats_page_close(const StatsPage *page)
+{
+    if (page != nullptr)
+        munmap((void *) page, sizeof(StatsPage));
+}
+
+void stats_page_unlink(const char *name)
+{
+    shm_unlink(name);
+}
@@ -0,0 +1,129 @@
+#ifndef STATS_PAGE_H
+#define STATS_PAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Shared memory page with the live metrics of a simulation run.
+ *
+ * The page is written by the StatsPublisher module and can be polled by any
+ * number of readers (see tools/stats_page_reader.cc). There are no locks:
+ * each slot is protected by a seqlock, the writer makes its seq odd while
+ * writing it, and readers retry their copy if seq was odd or has changed.
+ * The writer is never blocked by the readers.
+*/
+
+#define STATS_PAGE_MAGIC 0x53544c43
+#define STATS_PAGE_VERSION 1
+#define STATS_PAGE_DEFAULT_NAME "/cl_stats"
+#define STATS_PAGE_MAX_NODES 32
+#define STATS_PAGE_MAX_QUEUES 64
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+ "shared memory seqlocks need address-free 32 bit atomics");
+
+/**
+ * Run wide metrics.
+*/
+struct StatsRunSlot {
+  // simulated seconds
+  double sim_time;
+  // simulated seconds per wall clock second, in the last publish interval
+  double sim_speed;
+  uint64_t publish_count;
+  uint32_t num_nodes;
+  // set at the end of the run
+  uint32_t finished;
+};
+
+/**
+ * Metrics of a node.
+*/
+struct StatsNodeSlot {
+  // counters
+  uint64_t actions;
+  uint64_t send_actions;
+  double cumulative_reward;
+  // gauges
+  double battery_charge_level;
+  // actions per simulated second, in the last publish interval
+  double actions_per_second;
+  uint32_t num_queues;
+  uint32_t reserved;
+  float queue_occupancy[STATS_PAGE_MAX_QUEUES];
+};
+
+template <class T>
+struct StatsSeqlock {
+  std::atomic<uint32_t> seq;
+  uint32_t reserved;
+  T data;
+
+  /**
+   * Must be called by the only writer of the slot.
+  */
+  void write(const T &value) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy((void *) &data, &value, sizeof(T));
+    seq.store(s + 2, std::memory_order_release);
+  }
+
+  /**
+   * Copies a consistent snapshot of the slot, retrying at most max_tries
+   * times while the writer updates it. Returns false if it never managed.
+  */
+  bool read(T &value, int max_tries = 1000) const {
+    uint32_t before;
+
+    for (int i = 0; i < max_tries; i ++){
+      before = seq.load(std::memory_order_acquire);
+      if (before & 1)
+        continue;
+      memcpy(&value, (const void *) &data, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq.load(std::memory_order_relaxed) == before)
+        return true;
+    }
+    return false;
+  }
+};
+
+struct StatsPage {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t max_nodes;
+  uint32_t max_queues;
+  uint32_t reserved[12];
+  StatsSeqlock<StatsRunSlot> run;
+  StatsSeqlock<StatsNodeSlot> nodes[STATS_PAGE_MAX_NODES];
+};
+
+static_assert(offsetof(StatsPage, run) == 64, "unexpected stats page layout");
+
+/**
+ * Creates the page with the given name, replacing any stale one.
+ * Returns nullptr and writes the reason to error on failure.
+*/
+StatsPage *stats_page_create(const char *name, std::string &error);
+
+/**
+ * Opens the page of a running simulation, read only.
+ * Returns nullptr and writes the reason to error on failure.
+*/
+const StatsPage *stats_page_open(const char *name, std::string &error);
+
+void stats_page_close(const StatsPage *page);
+
+/**
+ * Removes the page name, mapped pages stay valid until closed.
+*/
+void stats_page_unlink(const char *name);
+
+#endif // STATS_PAGE_H
@@ -0,0 +1,174 @@
+#include "stats_publisher.h"
+#include <algorithm>
+
+Define_Module(StatsPublisher);
+
+void StatsPublisher::initialize()
+{
+    init_module_params();
+    init_page();
+    init_listeners();
+
+    last_publish_wall = chrono::steady_clock::now();
+    publish_timer = new cMessage("publish_stats");
+    scheduleAfter(publish_interval, publish_timer);
+}
+
+void StatsPublisher::init_module_params()
+{
+    node_name = par("node_name").stringValue();
+    publish_interval = par("publish_interval").doubleValue();
+    page_name = par("page_name").stdstringValue();
+}
+
+void StatsPublisher::init_page()
+{
+    string error;
+
+    // runs of a sweep get a page each
+    if (page_name.empty())
+        page_name = string(STATS_PAGE_DEFAULT_NAME) + "."
+         + getEnvir()->getConfigEx()->getVariable(CFGVAR_RUNNUMBER);
+
+    page = stats_page_create(page_name.c_str(), error);
+    if (page == nullptr)
+        throw cRuntimeError("StatsPublisher: cannot create stats page: %s", error.c_str());
+    EV_INFO << "Publishing live stats in " << page_name << endl;
+}
+
+void StatsPublisher::init_listeners()
+{
+    cModule *network = getParentModule();
+    int num_nodes = network->getSubmoduleVectorSize(node_name);
+    cModule *node;
+    int num_queues;
+    simsignal_t queue_signal;
+    char queue_signal_name[64];
+
+    if (num_nodes > STATS_PAGE_MAX_NODES)
+        EV_WARN << "StatsPublisher: only the first " << STATS_PAGE_MAX_NODES
+         << " nodes are published" << endl;
+    num_nodes = min(num_nodes, STATS_PAGE_MAX_NODES);
+    node_slots.assign(num_nodes, StatsNodeSlot());
+    last_actions.assign(num_nodes, 0);
+    run_slot.num_nodes = num_nodes;
+
+    for (int i = 0; i < num_nodes; i ++){
+        node = network->getSubmodule(node_name, i);
+        num_queues = min(node->getSubmoduleVectorSize("queues"), STATS_PAGE_MAX_QUEUES);
+        node_slots[i].num_queues = num_queues;
+        for (int j = 0; j < num_queues; j ++){
+            snprintf(queue_signal_name, sizeof(queue_signal_name), "queue%d_pop_percentage",
+             (int) node->getSubmodule("queues", j)->par("priority").intValue());
+            queue_signal = registerSignal(queue_signal_name);
+            if (find(queue_signals.begin(), queue_signals.end(), queue_signal) == queue_signals.end())
+                queue_signals.push_back(queue_signal);
+        }
+    }
+
+    // signals of the nodes reach the network, so one subscription is enough
+    battery_charge_level_signal = registerSignal("battery_charge_level");
+    reward_signal = registerSignal("reward");
+    action_signal = registerSignal("action");
+    network->subscribe(battery_charge_level_signal, this);
+    network->subscribe(reward_signal, this);
+    network->subscribe(action_signal, this);
+    for (simsignal_t signal : queue_signals){
+        network->subscribe(signal, this);
+    }
+}
+
+StatsNodeSlot *StatsPublisher::node_slot(cComponent *src)
+{
+    cModule *node = src->getParentModule();
+
+    if (node == nullptr || !node->isName(node_name) || node->getIndex() >= (int) node_slots.size())
+        return nullptr;
+    return &node_slots[node->getIndex()];
+}
+
+void StatsPublisher::receive_value(cComponent *src, simsignal_t id, double value)
+{
+    StatsNodeSlot *slot = node_slot(src);
+    int queue;
+
+    if (slot == nullptr)
+        return;
+
+    if (id == battery_charge_level_signal)
+        slot->battery_charge_level = value;
+    else if (id == reward_signal)
+        slot->cumulative_reward += value;
+    else if (id == action_signal){
+        slot->actions ++;
+        // action 0 is do nothing
+        if (value != 0)
+            slot->send_actions ++;
+    }
+    else if (src->isName("queues")){
+        queue = ((cModule *) src)->getIndex();
+        if (queue < (int) slot->num_queues)
+            slot->queue_occupancy[queue] = value;
+    }
+}
+
+void StatsPublisher::publish()
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double sim_elapsed = (simTime() - last_publish_time).dbl();
+    double wall_elapsed = chrono::duration<double>(now - last_publish_wall).count();
+
+    for (size_t i = 0; i < node_slots.size(); i ++){
+        if (sim_elapsed > 0)
+            node_slots[i].actions_per_second = (node_slots[i].actions - last_actions[i]) / sim_elapsed;
+        last_actions[i] = node_slots[i].actions;
+        page->nodes[i].write(node_slots[i]);
+    }
+
+    run_slot.sim_time = simTime().dbl();
+    if (wall_elapsed > 0)
+        run_slot.sim_speed = sim_elapsed / wall_elapsed;
+    run_slot.publish_count ++;
+    page->run.write(run_slot);
+
+    last_publish_time = simTime();
+    last_publish_wall = now;
+}
+
+void StatsPublisher::handleMessage(cMessage *msg)
+{
+    if (msg != publish_timer){
+        EV_ERROR << getName() << ": unexpected message " << msg->getName() << endl;
+        delete msg;
+        return;
+    }
+
+    publish();
+    scheduleAfter(publish_interval, publish_timer);
+}
+
+void StatsPublisher::finish()
+{
+    run_slot.finished = 1;
+    publish();
+}
+
+StatsPublisher::~StatsPublisher()
+{
+    cModule *network = getParentModule();
+
+    cancelAndDelete(publish_timer);
+    if (page == nullptr)
+        return;
+
+    network->unsubscribe(battery_charge_level_signal, this);
+    network->unsubscribe(reward_signal, this);
+    network->unsubscribe(action_signal, this);
+    for (simsignal_t signal : queue_signals){
+        network->unsubscribe(signal, this);
+    }
+
+    // readers that mapped the page can still read the final metrics
+    stats_page_close(page);
+    stats_page_unlink(page_name.c_str());
+}
@@ -0,0 +1,80 @@
+#ifndef STATS_PUBLISHER_H
+#define STATS_PUBLISHER_H
+
+#include <omnetpp.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "stats_page.h"
+
+using namespace omnetpp;
+using namespace std;
+
+/**
+ * Publishes the live metrics of the nodes of the network in a shared memory
+ * StatsPage, so a run can be monitored while it goes on without writing
+ * files, see tools/stats_page_reader.cc.
+ *
+ * It listens to the signals of the nodes at the network level and keeps the
+ * metrics in local slots, which are copied in the page every publish_interval
+ * of simulated time.
+*/
+class StatsPublisher : public cSimpleModule, public cListener
+{
+  protected:
+    StatsPage *page = nullptr;
+    string page_name;
+    cMessage *publish_timer = nullptr;
+
+    vector<StatsNodeSlot> node_slots;
+    StatsRunSlot run_slot = {};
+    vector<uint64_t> last_actions;
+    simtime_t last_publish_time = 0;
+    chrono::steady_clock::time_point last_publish_wall;
+
+    simsignal_t battery_charge_level_signal;
+    simsignal_t reward_signal;
+    simsignal_t action_signal;
+    // queue occupancy signals, one per queue priority
+    vector<simsignal_t> queue_signals;
+
+    /**
+     * Module parameters:
+    */
+    const char *node_name;
+    simtime_t publish_interval;
+    /* Module parameters (END)*/
+
+    virtual void initialize() override;
+    virtual void handleMessage(cMessage *msg) override;
+    virtual void finish() override;
+
+    void init_module_params();
+    void init_page();
+    void init_listeners();
+
+    void publish();
+    /**
+     * Returns the slot of the node the src module belongs to, or nullptr.
+    */
+    StatsNodeSlot *node_slot(cComponent *src);
+    void receive_value(cComponent *src, simsignal_t id, double value);
+
+  public:
+    virtual ~StatsPublisher();
+
+    virtual void receiveSignal(cComponent *src, simsignal_t id, intval_t value,
+     cObject *details) override {
+      receive_value(src, id, value);
+    }
+    virtual void receiveSignal(cComponent *src, simsignal_t id, uintval_t value,
+     cObject *details) override {
+      receive_value(src, id, value);
+    }
+    virtual void receiveSignal(cComponent *src, simsignal_t id, double value,
+     cObject *details) override {
+      receive_value(src, id, value);
+    }
+};
+
+#endif // STATS_PUBLISHER_H
@@ -0,0 +1,170 @@
+#include "vector_codec.h"
+#include <cstring>
+
+static inline void put_varint(uint64_t value, vector<uint8_t> &out)
+{
+    while (value >= 0x80){
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+static inline bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7){
+        value |= (uint64_t) (*p & 0x7f) << shift;
+        if (!(*p++ & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static inline uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value)
+{
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+static inline uint64_t double_bits(double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double bits_double(uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void encode_vector_block(uint32_t vector_id, const int64_t *times,
+ const double *values, uint32_t n, vector<uint8_t> &out)
+{
+    VectorBlockHeader header = {};
+    size_t header_pos = out.size();
+    size_t column_pos;
+    int64_t delta;
+    int64_t last_delta = 0;
+    uint64_t bits;
+    uint64_t last_bits = 0;
+    int leading;
+    int trailing;
+
+    header.magic = VECTOR_BLOCK_MAGIC;
+    header.vector_id = vector_id;
+    header.count = n;
+    header.first_time = n > 0 ? times[0] : 0;
+    out.resize(out.size() + sizeof(header));
+
+    column_pos = out.size();
+    for (uint32_t i = 1; i < n; i ++){
+        delta = times[i] - times[i - 1];
+        put_varint(zigzag(delta - last_delta), out);
+        last_delta = delta;
+    }
+    header.time_bytes = out.size() - column_pos;
+
+    column_pos = out.size();
+    for (uint32_t i = 0; i < n; i ++){
+        bits = double_bits(values[i]) ^ last_bits;
+        last_bits ^= bits;
+        if (bits == 0){
+            out.push_back(0);
+            continue;
+        }
+        leading = __builtin_clzll(bits) / 8;
+        trailing = __builtin_ctzll(bits) / 8;
+        out.push_back((uint8_t) (1 + leading * 8 + trailing));
+        bits >>= trailing * 8;
+        for (int b = 0; b < 8 - leading - trailing; b ++){
+            out.push_back((uint8_t) bits);
+            bits >>= 8;
+        }
+    }
+    header.value_bytes = out.size() - column_pos;
+
+    memcpy(out.data() + header_pos, &header, sizeof(header));
+}
+
+size_t read_vector_block_header(const uint8_t *data, size_t size,
+ VectorBlockHeader &header)
+{
+    size_t block_size;
+
+    if (size < sizeof(header))
+        return 0;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != VECTOR_BLOCK_MAGIC)
+        return 0;
+    block_size = sizeof(header) + (size_t) header.time_bytes + header.value_bytes;
+    return block_size <= size ? block_size : 0;
+}
+
+size_t decode_vector_block(const uint8_t *data, size_t size,
+ VectorBlockHeader &header, vector<int64_t> &times, vector<double> &values)
+{
+    size_t block_size = read_vector_block_header(data, size, header);
+    const uint8_t *p = data + sizeof(header);
+    const uint8_t *end;
+    uint64_t encoded;
+    int64_t delta = 0;
+    uint64_t bits;
+    uint64_t last_bits = 0;
+    int leading;
+    int trailing;
+
+    times.clear();
+    values.clear();
+    if (block_size == 0)
+        return 0;
+    if (header.count == 0)
+        return block_size;
+
+    times.reserve(header.count);
+    times.push_back(header.first_time);
+    end = p + header.time_bytes;
+    for (uint32_t i = 1; i < header.count; i ++){
+        if (!get_varint(p, end, encoded))
+            return 0;
+        delta += unzigzag(encoded);
+        times.push_back(times.back() + delta);
+    }
+    if (p != end)
+        return 0;
+
+    values.reserve(header.count);
+    end = p + header.value_bytes;
+    for (uint32_t i = 0; i < header.count; i ++){
+        if (p >= end || *p > 64)
+            return 0;
+        if (*p == 0){
+            p ++;
+            values.push_back(bits_double(last_bits));
+            continue;
+        }
+        leading = (*p - 1) / 8;
+        trailing = (*p - 1) % 8;
+        p ++;
+        if (leading + trailing >= 8 || end - p < 8 - leading - trailing)
+            return 0;
+        bits = 0;
+        for (int b = 0; b < 8 - leading - trailing; b ++){
+            bits |= (uint64_t) *p++ << (b * 8);
+        }
+        last_bits ^= bits << (trailing * 8);
+        values.push_back(bits_double(last_bits));
+    }
+    if (p != end)
+        return 0;
+    return block_size;
+}
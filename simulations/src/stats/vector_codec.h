@@ -0,0 +1,68 @@
+#ifndef VECTOR_CODEC_H
+#define VECTOR_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Encoding of the chunk files written by ColumnarOutputVectorManager.
+ *
+ * A chunk file starts with a VectorChunkHeader and is followed by blocks.
+ * A block holds consecutive samples of a single vector: a VectorBlockHeader,
+ * the time column and the value column. All fields are little endian.
+ *
+ * - time column: raw simulation times, as delta of deltas from first_time,
+ *   zigzag varint encoded. Regularly spaced samples take one byte each.
+ * - value column: each value is XORed with the previous one, a control byte
+ *   tells how many leading and trailing zero bytes the XOR has and only the
+ *   bytes in between follow. Repeated values take one byte each.
+ *
+ * It does not depend on OMNeT++, so standalone tools can read the chunks.
+*/
+
+#define VECTOR_CHUNK_MAGIC 0x43434556 // "VECC"
+#define VECTOR_BLOCK_MAGIC 0x4b4c4256 // "VBLK"
+#define VECTOR_CHUNK_VERSION 1
+
+struct VectorChunkHeader {
+    uint32_t magic;
+    uint32_t version;
+    // simulation time of a sample is raw time * 10^time_scale_exp seconds
+    int32_t time_scale_exp;
+    uint32_t reserved;
+};
+
+struct VectorBlockHeader {
+    uint32_t magic;
+    uint32_t vector_id;
+    uint32_t count;
+    uint32_t time_bytes;
+    uint32_t value_bytes;
+    uint32_t reserved;
+    int64_t first_time;
+};
+
+/**
+ * Appends to out the block of the n samples of a vector.
+*/
+void encode_vector_block(uint32_t vector_id, const int64_t *times,
+ const double *values, uint32_t n, vector<uint8_t> &out);
+
+/**
+ * Reads the header of the block at data. Returns the size of the whole
+ * block, or 0 if the block is malformed or truncated.
+*/
+size_t read_vector_block_header(const uint8_t *data, size_t size,
+ VectorBlockHeader &header);
+
+/**
+ * Decodes the block at data, replacing the contents of times and values.
+ * Returns the size of the block, or 0 if it is malformed or truncated.
+*/
+size_t decode_vector_block(const uint8_t *data, size_t size,
+ VectorBlockHeader &header, vector<int64_t> &times, vector<double> &values);
+
+#endif // VECTOR_CODEC_H
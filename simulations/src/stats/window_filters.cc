@@ -0,0 +1,177 @@
+#include "window_filters.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+Register_ResultFilter("windowMean", WindowMeanFilter);
+Register_ResultFilter("windowMax", WindowMaxFilter);
+Register_ResultFilter("windowRate", WindowRateFilter);
+Register_ResultFilter("tumblingSum", TumblingSumFilter);
+
+static const char *statistic_attribute(cResultFilter::Context *ctx, const char *name)
+{
+    const char *value;
+
+    if (ctx->attrsProperty == nullptr)
+        return nullptr;
+    value = ctx->attrsProperty->getValue(name);
+    return value != nullptr && *value != '\0' ? value : nullptr;
+}
+
+void WindowFilter::init(Context *ctx)
+{
+    const char *size_attr = statistic_attribute(ctx, "windowSize");
+    const char *time_attr = statistic_attribute(ctx, "windowTime");
+    const char *emit_attr = statistic_attribute(ctx, "windowEmit");
+
+    cNumericResultFilter::init(ctx);
+
+    if (time_attr != nullptr){
+        window_time = SimTime::parse(time_attr);
+        if (window_time <= 0)
+            throw cRuntimeError("windowTime must be positive, got %s", time_attr);
+    }
+    else if (size_attr != nullptr){
+        if (atol(size_attr) <= 0)
+            throw cRuntimeError("windowSize must be positive, got %s", size_attr);
+        window_size = atol(size_attr);
+    }
+    else
+        window_size = WINDOW_SIZE_DEFAULT;
+
+    if (emit_attr != nullptr && strcmp(emit_attr, "boundary") == 0)
+        emit_at_boundary = true;
+    else if (emit_attr != nullptr && strcmp(emit_attr, "always") != 0)
+        throw cRuntimeError("windowEmit must be \"always\" or \"boundary\", got %s", emit_attr);
+
+    next_boundary = simTime() + window_time;
+}
+
+bool WindowFilter::cross_boundary(simtime_t_cref t)
+{
+    if (window_time > 0){
+        if (t < next_boundary)
+            return false;
+        // skips the windows without values
+        next_boundary += window_time * (floor((t - next_boundary) / window_time) + 1);
+        return true;
+    }
+
+    if (++ values_since_boundary < window_size)
+        return false;
+    values_since_boundary = 0;
+    return true;
+}
+
+bool WindowFilter::expired(const Sample &sample, simtime_t_cref now) const
+{
+    if (window_time > 0)
+        return sample.t <= now - window_time;
+    return num_values - sample.seq > window_size;
+}
+
+bool WindowMeanFilter::process(simtime_t& t, double& value, cObject *details)
+{
+    if (std::isnan(value))
+        return false;
+
+    window.push_back({t, value, num_values ++});
+    sum += value;
+    while (expired(window.front(), t)){
+        sum -= window.front().value;
+        window.pop_front();
+    }
+    // rounding errors of the running sum are dropped with an empty window
+    if (window.size() == 1)
+        sum = value;
+
+    if (!forward(t))
+        return false;
+    value = sum / window.size();
+    return true;
+}
+
+bool WindowMaxFilter::process(simtime_t& t, double& value, cObject *details)
+{
+    if (std::isnan(value))
+        return false;
+
+    while (!candidates.empty() && candidates.back().value <= value){
+        candidates.pop_back();
+    }
+    candidates.push_back({t, value, num_values ++});
+    while (expired(candidates.front(), t)){
+        candidates.pop_front();
+    }
+
+    if (!forward(t))
+        return false;
+    value = candidates.front().value;
+    return true;
+}
+
+void WindowRateFilter::init(Context *ctx)
+{
+    WindowFilter::init(ctx);
+    if (window_time == 0){
+        window_time = WINDOW_TIME_DEFAULT;
+        window_size = 0;
+        next_boundary = simTime() + window_time;
+    }
+}
+
+bool WindowRateFilter::process(simtime_t& t, double& value, cObject *details)
+{
+    if (std::isnan(value))
+        return false;
+
+    window.push_back({t, value, num_values ++});
+    sum += value;
+    while (expired(window.front(), t)){
+        sum -= window.front().value;
+        window.pop_front();
+    }
+    if (window.size() == 1)
+        sum = value;
+
+    if (!forward(t))
+        return false;
+    value = sum / window_time.dbl();
+    return true;
+}
+
+void TumblingSumFilter::init(Context *ctx)
+{
+    WindowFilter::init(ctx);
+    if (window_time == 0){
+        window_time = WINDOW_TIME_DEFAULT;
+        window_size = 0;
+        next_boundary = simTime() + window_time;
+    }
+}
+
+bool TumblingSumFilter::process(simtime_t& t, double& value, cObject *details)
+{
+    simtime_t window_end = next_boundary;
+    double window_sum = sum;
+    bool crossed;
+
+    if (std::isnan(value))
+        return false;
+
+    crossed = cross_boundary(t);
+    if (crossed){
+        sum = value;
+    }
+    else {
+        sum += value;
+    }
+    if (!crossed || !has_values){
+        has_values = true;
+        return false;
+    }
+
+    t = window_end;
+    value = window_sum;
+    return true;
+}
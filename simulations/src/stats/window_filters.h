@@ -0,0 +1,118 @@
+#ifndef WINDOW_FILTERS_H
+#define WINDOW_FILTERS_H
+
+#include <omnetpp.h>
+#include <cstddef>
+#include <deque>
+
+using namespace omnetpp;
+using namespace std;
+
+// window of the sliding filters when neither windowSize nor windowTime is set
+#define WINDOW_SIZE_DEFAULT 100
+// window of tumblingSum when windowTime is not set
+#define WINDOW_TIME_DEFAULT 1.0
+
+/**
+ * Base of the filters aggregating the values in a window.
+ *
+ * The window is configured with the attributes of the statistic:
+ * - windowSize: the window holds the last windowSize values;
+ * - windowTime: the window holds the values of the last windowTime
+ *   seconds, e.g. windowTime=10s. It takes precedence over windowSize;
+ * - windowEmit: "always" (the default) outputs the aggregate at every value,
+ *   "boundary" only once per window, i.e. every windowSize values or
+ *   windowTime seconds, reducing the recorded values by the window factor.
+ *
+ * Usage: @statistic[name](source=windowMean(signal); record=vector; windowTime=1s; windowEmit=boundary)
+*/
+class WindowFilter : public cNumericResultFilter
+{
+  protected:
+    struct Sample {
+      simtime_t t;
+      double value;
+      // position of the value in the sequence of values of the filter
+      size_t seq;
+    };
+
+    size_t window_size = 0;
+    simtime_t window_time = 0;
+    bool emit_at_boundary = false;
+
+    size_t num_values = 0;
+    size_t values_since_boundary = 0;
+    simtime_t next_boundary = 0;
+
+    virtual void init(Context *ctx) override;
+    /**
+     * Returns true if the window boundary is crossed at time t, i.e. if
+     * the filter must output its value when emit_at_boundary is set.
+    */
+    bool cross_boundary(simtime_t_cref t);
+    /**
+     * Returns true if the sample must leave the window at time now,
+     * after num_values values.
+    */
+    bool expired(const Sample &sample, simtime_t_cref now) const;
+    bool forward(simtime_t_cref t) {
+      return cross_boundary(t) || !emit_at_boundary;
+    }
+};
+
+/**
+ * Mean of the values in the window. O(1) per value.
+*/
+class WindowMeanFilter : public WindowFilter
+{
+  protected:
+    deque<Sample> window;
+    double sum = 0;
+
+    virtual bool process(simtime_t& t, double& value, cObject *details) override;
+};
+
+/**
+ * Max of the values in the window, kept with a monotonic deque.
+ * O(1) amortized per value.
+*/
+class WindowMaxFilter : public WindowFilter
+{
+  protected:
+    // decreasing values of the window, the first one is the max
+    deque<Sample> candidates;
+
+    virtual bool process(simtime_t& t, double& value, cObject *details) override;
+};
+
+/**
+ * Sum of the values in the window per second of the window, e.g. packets
+ * per second with a signal emitting 1 for each packet. O(1) per value.
+ * The window is always a time window, windowTime is 1s if not set.
+*/
+class WindowRateFilter : public WindowFilter
+{
+  protected:
+    deque<Sample> window;
+    double sum = 0;
+
+    virtual void init(Context *ctx) override;
+    virtual bool process(simtime_t& t, double& value, cObject *details) override;
+};
+
+/**
+ * Sum of the values in consecutive, non overlapping windows of windowTime
+ * seconds. The sum of a window is output, with the time of its end, by the
+ * first value after it; windows without values output nothing.
+*/
+class TumblingSumFilter : public WindowFilter
+{
+  protected:
+    double sum = 0;
+    bool has_values = false;
+
+    virtual void init(Context *ctx) override;
+    virtual bool process(simtime_t& t, double& value, cObject *details) override;
+};
+
+#endif // WINDOW_FILTERS_H
@@ -0,0 +1,109 @@
+/**
+ * Test of the vector lifetime of ColumnarOutputVectorManager.
+ *
+ * Recorders deregister their vectors when the network is deleted, which
+ * happens after endRun(): handles must stay valid until then. Build it with
+ * -DBUILD_TESTS=ON, it runs under AddressSanitizer, which catches any use
+ * of a freed vector.
+ *
+ * Usage: columnar_vector_manager_test [dir]
+*/
+
+#include <omnetpp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "stats/columnar_vector_manager.h"
+
+using namespace omnetpp;
+using namespace std;
+
+#define check(_cond) if (!(_cond)) { \
+    fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond); \
+    exit(1); }
+
+/**
+ * Manager that does not read the configuration of the environment.
+*/
+class TestVectorManager : public ColumnarOutputVectorManager
+{
+  protected:
+    bool vector_recording_enabled(const char *object_name) override {
+      return true;
+    }
+
+  public:
+    void start(const string &dir_name) {
+      start_run(dir_name, 1 << 20, 4);
+    }
+};
+
+/**
+ * Returns the number of samples of the vector in the chunks of dir_name.
+*/
+static size_t count_samples(const string &dir_name, uint32_t id)
+{
+    VectorBlockHeader header;
+    vector<int64_t> times;
+    vector<double> values;
+    size_t count = 0;
+    size_t offset;
+    size_t block_size;
+
+    for (const filesystem::directory_entry &entry : filesystem::directory_iterator(dir_name)){
+        if (entry.path().extension() != ".bin")
+            continue;
+        ifstream in(entry.path(), ios::binary);
+        vector<uint8_t> data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+        check(data.size() >= sizeof(VectorChunkHeader));
+        for (offset = sizeof(VectorChunkHeader); offset < data.size(); offset += block_size){
+            block_size = decode_vector_block(data.data() + offset, data.size() - offset,
+             header, times, values);
+            check(block_size > 0);
+            if (header.vector_id == id)
+                count += header.count;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    string dir_name = argc > 1 ? argv[1] : "columnar_vector_manager_test.vecc";
+    TestVectorManager *manager = new TestVectorManager();
+    void *first;
+    void *second;
+    void *left;
+
+    // deregistered after the end of the run, as when the network is deleted
+    manager->start(dir_name);
+    first = manager->registerVector("Net.node[0]", "first");
+    second = manager->registerVector("Net.node[0]", "second");
+    for (int i = 0; i < 10; i ++){
+        check(manager->record(first, i, i));
+    }
+    check(manager->record(second, 1, 1));
+    manager->deregisterVector(second);
+    manager->endRun();
+    check(!manager->record(first, 11, 11));
+    manager->deregisterVector(first);
+    check(count_samples(dir_name, 0) == 10);
+    check(count_samples(dir_name, 1) == 1);
+
+    // a vector still registered at the end is freed with the manager
+    manager->start(dir_name);
+    left = manager->registerVector("Net.node[0]", "left");
+    check(manager->record(left, 1, 1));
+    manager->endRun();
+    check(count_samples(dir_name, 0) == 1);
+    delete manager;
+
+    filesystem::remove_all(dir_name);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * Native stand-in for the agent server, answering the requests of
+ * AgentClientShm with a random policy.
+ *
+ * It speaks the same shared memory protocol of agent/shm_server.py, so the
+ * transport can be benchmarked and tested without Python.
+ * Actions are drawn uniformly from the flat action space of the agent:
+ * action n_queues * 2 means do nothing, otherwise the queue is action / 2 and
+ * the power source is action % 2.
+ *
+ * Usage: agent_shm_server [shm name] [seed]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include "node/agentc/shm_ring.h"
+
+using namespace std;
+
+// idle polls before the server starts sleeping between polls
+#define IDLE_SPIN_POLLS 4096
+#define IDLE_SLEEP_US 50
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int)
+{
+    stop = 1;
+}
+
+static ShmActionResponse random_action(const ShmActionRequest &request, mt19937_64 &rng)
+{
+    ShmActionResponse response;
+    uniform_int_distribution<int> actions(0, request.num_queues * 2);
+    int action = actions(rng);
+
+    response.seq = request.seq;
+    response.msg_to_send = 1;
+    if (action == (int) request.num_queues * 2){
+        response.send_message = 0;
+        response.power_source = -1;
+        response.queue = -1;
+    } else {
+        response.send_message = 1;
+        response.queue = action / 2;
+        response.power_source = action % 2;
+    }
+    return response;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : SHM_AGENT_DEFAULT_NAME;
+    mt19937_64 rng(argc > 2 ? strtoull(argv[2], nullptr, 10) : random_device()());
+    uint32_t generations[SHM_AGENT_MAX_CHANNELS] = {0};
+    unsigned long long served = 0;
+    unsigned int idle_polls = 0;
+    ShmAgentSegment *segment;
+    string error;
+
+    segment = shm_agent_create(name, error);
+    if (segment == nullptr){
+        fprintf(stderr, "Cannot create agent server segment: %s\n", error.c_str());
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    printf("Serving random policy on %s with %u channels\n", name, segment->num_channels);
+
+    while (!stop){
+        bool busy = false;
+
+        for (uint32_t i = 0; i < segment->num_channels; i ++){
+            ShmAgentChannel &channel = segment->channels[i];
+            ShmActionRequest request;
+
+            if (channel.state.load(memory_order_acquire) != SHM_CHANNEL_ACTIVE)
+                continue;
+            if (channel.generation.load(memory_order_relaxed) != generations[i]){
+                generations[i] = channel.generation.load(memory_order_relaxed);
+                printf("Channel %u claimed with %u queues, implementation %s\n",
+                 i, channel.num_queues, channel.implementation);
+            }
+            while (channel.requests.pop(request)){
+                // the client waits for each response, so the ring never fills up
+                while (!channel.responses.push(random_action(request, rng)))
+                    this_thread::yield();
+                served++;
+                busy = true;
+            }
+        }
+
+        if (busy){
+            idle_polls = 0;
+        } else if (++idle_polls > IDLE_SPIN_POLLS){
+            this_thread::sleep_for(chrono::microseconds(IDLE_SLEEP_US));
+        }
+    }
+
+    printf("Served %llu requests\n", served);
+    shm_agent_close(segment);
+    shm_agent_unlink(name);
+    return 0;
+}
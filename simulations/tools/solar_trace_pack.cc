@@ -0,0 +1,81 @@
+/**
+ * Packs a text solar trace in the binary format read by TraceCharger.
+ *
+ * Each line of the input holds a time in seconds and the output of the
+ * solar panel at that time, as a fraction of its capacity between 0 and 1.
+ * Empty lines and lines starting with # are skipped. Times must not
+ * decrease.
+ *
+ * Usage:
+ *   solar_trace_pack <input.txt> <output.bin>
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "node/power/solar_trace.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    vector<SolarTraceSample> samples;
+    SolarTraceSample sample;
+    SolarTraceHeader header;
+    string line;
+    size_t line_number = 0;
+    FILE *out;
+
+    if (argc != 3){
+        fprintf(stderr, "usage: %s <input.txt> <output.bin>\n", argv[0]);
+        return 1;
+    }
+
+    ifstream in(argv[1]);
+    if (!in){
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    while (getline(in, line)){
+        line_number ++;
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream fields(line);
+        if (!(fields >> sample.time >> sample.output)){
+            fprintf(stderr, "%s:%zu: expected time and output\n", argv[1], line_number);
+            return 1;
+        }
+        if (!samples.empty() && sample.time < samples.back().time){
+            fprintf(stderr, "%s:%zu: time decreases\n", argv[1], line_number);
+            return 1;
+        }
+        samples.push_back(sample);
+    }
+    if (samples.empty()){
+        fprintf(stderr, "%s: no samples\n", argv[1]);
+        return 1;
+    }
+
+    header.magic = SOLAR_TRACE_MAGIC;
+    header.version = SOLAR_TRACE_VERSION;
+    header.count = samples.size();
+
+    out = fopen(argv[2], "wb");
+    if (out == nullptr){
+        fprintf(stderr, "cannot open %s\n", argv[2]);
+        return 1;
+    }
+    if (fwrite(&header, sizeof(header), 1, out) != 1
+     || fwrite(samples.data(), sizeof(SolarTraceSample), samples.size(), out) != samples.size()){
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        fclose(out);
+        return 1;
+    }
+    fclose(out);
+    printf("%zu samples from %g s to %g s\n", samples.size(),
+     samples.front().time, samples.back().time);
+    return 0;
+}
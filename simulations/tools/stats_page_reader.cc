@@ -0,0 +1,87 @@
+/**
+ * Polls the live metrics published by StatsPublisher and prints them.
+ *
+ * It only maps the shared memory page read only, so it has no effect on the
+ * simulation. It exits when the run ends.
+ *
+ * Usage: stats_page_reader [page name | run number] [poll interval ms]
+*/
+
+#include <chrono>
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "stats/stats_page.h"
+
+using namespace std;
+
+#define DEFAULT_POLL_INTERVAL_MS 1000
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int)
+{
+    stop = 1;
+}
+
+static void print_metrics(const StatsRunSlot &run, const StatsPage *page)
+{
+    StatsNodeSlot node;
+
+    printf("sim time %.3fs, %.2f sim s/wall s, update %lu%s\n", run.sim_time, run.sim_speed,
+     (unsigned long) run.publish_count, run.finished ? ", finished" : "");
+    printf("%6s %10s %10s %12s %14s %12s  %s\n", "node", "actions", "sends", "actions/s",
+     "cum reward", "battery", "queue occupancy %");
+    for (uint32_t i = 0; i < run.num_nodes && i < STATS_PAGE_MAX_NODES; i ++){
+        if (!page->nodes[i].read(node)){
+            printf("%6u (busy)\n", i);
+            continue;
+        }
+        printf("%6u %10lu %10lu %12.2f %14.3f %12.3f ", i, (unsigned long) node.actions,
+         (unsigned long) node.send_actions, node.actions_per_second, node.cumulative_reward,
+         node.battery_charge_level);
+        for (uint32_t q = 0; q < node.num_queues && q < STATS_PAGE_MAX_QUEUES; q ++){
+            printf(" %5.1f", node.queue_occupancy[q]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    string name = STATS_PAGE_DEFAULT_NAME ".0";
+    int interval_ms = argc > 2 ? atoi(argv[2]) : DEFAULT_POLL_INTERVAL_MS;
+    const StatsPage *page;
+    StatsRunSlot run;
+    string error;
+    uint64_t last_publish_count = UINT64_MAX;
+
+    if (argc > 1)
+        name = isdigit(argv[1][0]) ? string(STATS_PAGE_DEFAULT_NAME) + "." + argv[1] : argv[1];
+
+    page = stats_page_open(name.c_str(), error);
+    if (page == nullptr){
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    while (!stop){
+        if (page->run.read(run) && run.publish_count != last_publish_count){
+            last_publish_count = run.publish_count;
+            print_metrics(run, page);
+            if (run.finished)
+                break;
+        }
+        this_thread::sleep_for(chrono::milliseconds(interval_ms));
+    }
+
+    stats_page_close(page);
+    return 0;
+}
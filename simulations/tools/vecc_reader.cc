@@ -0,0 +1,232 @@
+/**
+ * Reader of the vectors written by ColumnarOutputVectorManager.
+ *
+ * Chunk files are memory mapped and only the blocks of the requested vector
+ * are decoded. Chunks still being written (.part) are skipped, so the reader
+ * can be used while the simulation runs.
+ *
+ * Usage:
+ *   vecc_reader <dir> list                 vectors and their number of samples
+ *   vecc_reader <dir> dump <id>            samples of a vector, as time value
+ *   vecc_reader <dir> dump <module> <name>
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "stats/vector_codec.h"
+
+using namespace std;
+
+struct VectorInfo {
+    uint32_t id;
+    string module_name;
+    string vector_name;
+    uint64_t count = 0;
+};
+
+struct Chunk {
+    string file_name;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
+
+static vector<VectorInfo> read_index(const string &dir_name)
+{
+    ifstream index(dir_name + "/index.tsv");
+    vector<VectorInfo> vectors;
+    string line;
+    string kind;
+    VectorInfo info;
+
+    if (!index){
+        fprintf(stderr, "cannot open %s/index.tsv\n", dir_name.c_str());
+        exit(1);
+    }
+    while (getline(index, line)){
+        istringstream fields(line);
+
+        getline(fields, kind, '\t');
+        if (kind != "vector")
+            continue;
+        fields >> info.id;
+        fields.ignore(1);
+        getline(fields, info.module_name, '\t');
+        getline(fields, info.vector_name, '\t');
+        if (vectors.size() <= info.id)
+            vectors.resize(info.id + 1);
+        vectors[info.id] = info;
+    }
+    return vectors;
+}
+
+static vector<Chunk> map_chunks(const string &dir_name)
+{
+    vector<Chunk> chunks;
+    DIR *dir = opendir(dir_name.c_str());
+    struct dirent *entry;
+    struct stat st;
+    string name;
+    int fd;
+
+    if (dir == nullptr){
+        fprintf(stderr, "cannot open %s\n", dir_name.c_str());
+        exit(1);
+    }
+    while ((entry = readdir(dir)) != nullptr){
+        name = entry->d_name;
+        if (name.rfind("chunk-", 0) == 0 && name.size() > 4
+         && name.compare(name.size() - 4, 4, ".bin") == 0)
+            chunks.push_back({dir_name + "/" + name});
+    }
+    closedir(dir);
+    // chunk names are zero padded, so they sort in writing order
+    sort(chunks.begin(), chunks.end(),
+     [](const Chunk &a, const Chunk &b) { return a.file_name < b.file_name; });
+
+    for (Chunk &chunk : chunks){
+        fd = open(chunk.file_name.c_str(), O_RDONLY);
+        if (fd < 0 || fstat(fd, &st) < 0){
+            fprintf(stderr, "cannot open %s\n", chunk.file_name.c_str());
+            exit(1);
+        }
+        chunk.size = st.st_size;
+        if (chunk.size > 0){
+            chunk.data = (const uint8_t *) mmap(nullptr, chunk.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (chunk.data == MAP_FAILED){
+                fprintf(stderr, "cannot map %s\n", chunk.file_name.c_str());
+                exit(1);
+            }
+        }
+        close(fd);
+    }
+    return chunks;
+}
+
+/**
+ * Checks the header of the chunk and returns its time scale, in seconds.
+*/
+static double chunk_time_scale(const Chunk &chunk)
+{
+    VectorChunkHeader chunk_header;
+
+    if (chunk.size < sizeof(chunk_header)){
+        fprintf(stderr, "%s is truncated\n", chunk.file_name.c_str());
+        exit(1);
+    }
+    memcpy(&chunk_header, chunk.data, sizeof(chunk_header));
+    if (chunk_header.magic != VECTOR_CHUNK_MAGIC || chunk_header.version != VECTOR_CHUNK_VERSION){
+        fprintf(stderr, "%s is not a vector chunk\n", chunk.file_name.c_str());
+        exit(1);
+    }
+    return pow(10, chunk_header.time_scale_exp);
+}
+
+/**
+ * Calls visit(header, block, block_size) for each block of the chunk.
+*/
+template <class Visitor>
+static void for_each_block(const Chunk &chunk, Visitor visit)
+{
+    VectorBlockHeader header;
+    size_t pos = sizeof(VectorChunkHeader);
+    size_t block_size;
+
+    chunk_time_scale(chunk);
+    while (pos < chunk.size){
+        block_size = read_vector_block_header(chunk.data + pos, chunk.size - pos, header);
+        if (block_size == 0){
+            fprintf(stderr, "%s: malformed block at offset %zu\n", chunk.file_name.c_str(), pos);
+            exit(1);
+        }
+        visit(header, chunk.data + pos, block_size);
+        pos += block_size;
+    }
+}
+
+static void list_vectors(vector<VectorInfo> &vectors, const vector<Chunk> &chunks)
+{
+    for (const Chunk &chunk : chunks){
+        for_each_block(chunk, [&](const VectorBlockHeader &header, const uint8_t *, size_t) {
+            if (header.vector_id < vectors.size())
+                vectors[header.vector_id].count += header.count;
+        });
+    }
+    printf("%s\t%s\t%s\t%s\n", "id", "module", "name", "count");
+    for (const VectorInfo &info : vectors){
+        if (!info.module_name.empty())
+            printf("%u\t%s\t%s\t%lu\n", info.id, info.module_name.c_str(),
+             info.vector_name.c_str(), (unsigned long) info.count);
+    }
+}
+
+static void dump_vector(uint32_t id, const vector<Chunk> &chunks)
+{
+    VectorBlockHeader decoded_header;
+    vector<int64_t> times;
+    vector<double> values;
+    double time_scale;
+
+    for (const Chunk &chunk : chunks){
+        time_scale = chunk_time_scale(chunk);
+        for_each_block(chunk, [&](const VectorBlockHeader &header, const uint8_t *block, size_t size) {
+            if (header.vector_id != id)
+                return;
+            decode_vector_block(block, size, decoded_header, times, values);
+            for (size_t i = 0; i < times.size(); i ++){
+                printf("%.12g\t%.17g\n", times[i] * time_scale, values[i]);
+            }
+        });
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    vector<VectorInfo> vectors;
+    vector<Chunk> chunks;
+    string command;
+    long id = -1;
+
+    if (argc < 3){
+        fprintf(stderr, "usage: %s <dir> list | dump <id> | dump <module> <name>\n", argv[0]);
+        return 1;
+    }
+    vectors = read_index(argv[1]);
+    chunks = map_chunks(argv[1]);
+    command = argv[2];
+
+    if (command == "list"){
+        list_vectors(vectors, chunks);
+        return 0;
+    }
+    if (command != "dump" || argc < 4){
+        fprintf(stderr, "usage: %s <dir> list | dump <id> | dump <module> <name>\n", argv[0]);
+        return 1;
+    }
+
+    if (argc == 4)
+        id = strtol(argv[3], nullptr, 10);
+    else {
+        for (const VectorInfo &info : vectors){
+            if (info.module_name == argv[3] && info.vector_name == argv[4])
+                id = info.id;
+        }
+    }
+    if (id < 0 || id >= (long) vectors.size() || vectors[id].module_name.empty()){
+        fprintf(stderr, "no such vector\n");
+        return 1;
+    }
+    dump_vector(id, chunks);
+    return 0;
+}